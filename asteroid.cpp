@@ -3,6 +3,8 @@
 namespace game {
 
 Asteroid::Asteroid(const std::string name, const Resource *geometry, const Resource *material) : SceneNode(name, geometry, material) {
+
+    angm_ = glm::vec3(0.0, 0.0, 0.0);
 }
 
 
@@ -10,21 +12,25 @@ Asteroid::~Asteroid(){
 }
 
 
-glm::quat Asteroid::GetAngM(void) const {
+glm::vec3 Asteroid::GetAngM(void) const {
 
     return angm_;
 }
 
 
-void Asteroid::SetAngM(glm::quat angm){
+void Asteroid::SetAngM(glm::vec3 angm){
 
     angm_ = angm;
 }
 
 
-void Asteroid::Update(void){
+void Asteroid::Update(float delta_time){
 
-    Rotate(angm_);
+    // Same spin speed whatever the length of the simulation steps
+    float speed = glm::length(angm_);
+    if (speed > 0.0){
+        Rotate(glm::angleAxis(speed*delta_time, angm_/speed));
+    }
 }
             
 } // namespace game
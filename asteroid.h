@@ -25,15 +25,17 @@ namespace game {
             ~Asteroid();
             
             // Get/set attributes specific to asteroids
-            glm::quat GetAngM(void) const;
-            void SetAngM(glm::quat angm);
+            // The angular momentum is the axis of the spin, scaled by its
+            // speed in radians per second
+            glm::vec3 GetAngM(void) const;
+            void SetAngM(glm::vec3 angm);
 
-            // Update geometry configuration
-            void Update(void);
+            // Update geometry configuration, spinning by the time elapsed
+            void Update(float delta_time);
             
         private:
             // Angular momentum of asteroid
-            glm::quat angm_;
+            glm::vec3 angm_;
     }; // class Asteroid
 
 } // namespace game
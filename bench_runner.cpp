@@ -0,0 +1,257 @@
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "profiler.h"
+#include "transform_kernel.h"
+
+// Macro for printing exceptions
+#define PrintException(exception_object)\
+	std::cerr << exception_object.what() << std::endl
+
+// Benchmark settings
+const int bench_frames_g = 1000; // Frames measured
+const int bench_warmup_g = 60; // Frames run before measuring
+const unsigned int bench_seed_g = 1; // Seed of the random numbers of the game
+const double bench_frame_time_g = 1.0/60.0; // Simulated time of a frame
+
+// Scripted inputs: one key every few frames, cycling through lane
+// changes, jumps and slides
+const int input_interval_g = 30;
+const int input_script_g[] = { GLFW_KEY_LEFT, GLFW_KEY_UP, GLFW_KEY_RIGHT, GLFW_KEY_DOWN,
+                               GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_LEFT, GLFW_KEY_DOWN };
+const int input_script_size_g = sizeof(input_script_g)/sizeof(input_script_g[0]);
+
+// Counts of the render statistics written out
+struct StatField {
+    const char *name;
+    int game::RenderStats::*count;
+};
+const StatField stats_g[] = {
+    { "draw_calls", &game::RenderStats::draw_calls },
+    { "triangles", &game::RenderStats::triangles },
+    { "points", &game::RenderStats::points },
+    { "program_changes", &game::RenderStats::program_changes },
+    { "buffer_uploads", &game::RenderStats::buffer_uploads },
+    { "texture_binds", &game::RenderStats::texture_binds },
+    { "uniform_uploads", &game::RenderStats::uniform_uploads },
+    { "nodes_traversed", &game::RenderStats::nodes_traversed },
+    { "nodes_drawn", &game::RenderStats::nodes_drawn },
+    { "nodes_skipped", &game::RenderStats::nodes_skipped }
+};
+const int num_stats_g = sizeof(stats_g)/sizeof(stats_g[0]);
+
+
+// Print the statistics of a set of times as a JSON object
+void WriteStats(std::ostream &out, std::vector<double> time){
+
+    std::sort(time.begin(), time.end());
+    double sum = 0.0;
+    for (int i = 0; i < time.size(); i++){
+        sum += time[i];
+    }
+
+    // Nearest-rank percentiles
+    double p[3] = { 50.0, 95.0, 99.0 };
+    double value[3];
+    for (int i = 0; i < 3; i++){
+        int rank = (int) ceil(p[i]/100.0*time.size());
+        value[i] = time[std::max(rank - 1, 0)];
+    }
+
+    out << "{\"min\": " << time.front() << ", \"p50\": " << value[0] << ", \"p95\": " << value[1]
+        << ", \"p99\": " << value[2] << ", \"max\": " << time.back() << ", \"mean\": " << sum/time.size() << "}";
+}
+
+
+// Benchmark: play the game headless with scripted inputs, and print the
+// frame times, the time of each profiler zone and the render statistics
+// as JSON
+// Options: --frames N, --warmup N, --seed S, --kernel scalar|sse|avx2,
+// --stress N and --depth D to add N asteroids in chains of depth D (1 for
+// a flat field), --replay FILE to play a recorded session instead of the
+// scripted inputs, up to its end or the frame count, and --output FILE
+// (standard output by default)
+// Scaling curves come from one run per node count, e.g., 1000, 10000,
+// 100000 and 1000000
+int main(int argc, char *argv[]){
+    game::Game app; // Game application
+    int frames = bench_frames_g;
+    int warmup = bench_warmup_g;
+    unsigned int seed = bench_seed_g;
+    std::string kernel;
+    int stress_nodes = 0;
+    int stress_depth = 1;
+    std::string replay;
+    std::string output;
+
+    for (int i = 1; i < argc; i++){
+        if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc)){
+            frames = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--warmup") == 0) && (i + 1 < argc)){
+            warmup = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc)){
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if ((strcmp(argv[i], "--kernel") == 0) && (i + 1 < argc)){
+            kernel = argv[++i];
+        } else if ((strcmp(argv[i], "--stress") == 0) && (i + 1 < argc)){
+            stress_nodes = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--depth") == 0) && (i + 1 < argc)){
+            stress_depth = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--replay") == 0) && (i + 1 < argc)){
+            replay = argv[++i];
+        } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)){
+            output = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--frames N] [--warmup N] [--seed S] [--kernel scalar|sse|avx2] [--stress N] [--depth D] [--replay FILE] [--output FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (frames < 1){
+        std::cerr << "Need at least one frame" << std::endl;
+        return 1;
+    }
+
+    if (kernel == "scalar"){
+        game::TransformKernel::SetPath(game::TransformKernel::Scalar);
+    } else if (kernel == "sse"){
+        game::TransformKernel::SetPath(game::TransformKernel::SSE);
+    } else if (kernel == "avx2"){
+        game::TransformKernel::SetPath(game::TransformKernel::AVX2);
+    } else if (!kernel.empty()){
+        std::cerr << "Unknown kernel " << kernel << std::endl;
+        return 1;
+    }
+
+    game::Profiler::SetThreadName("Main");
+
+    // Messages of the game go to the error stream, so that the standard
+    // output only holds the results
+    std::streambuf *out_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    std::vector<double> frame_time;
+    std::map<std::string, std::vector<double> > zone_time; // Time of each zone, per frame
+    std::vector<game::RenderStats> stats; // Submitted work, per frame
+    std::string renderer;
+    unsigned int checksum;
+    try {
+        // Same setup as the game, on an offscreen context
+        app.Init(true);
+        app.SetSeed(seed);
+        app.SetFixedFrameTime(bench_frame_time_g);
+        app.SetStressScene(stress_nodes, stress_depth);
+        if (!replay.empty()){
+            app.StartReplay(replay);
+        }
+        app.SetupResources();
+        app.SetupScene();
+        renderer = (const char *) glGetString(GL_RENDERER);
+
+        app.ResetClock();
+        std::vector<game::Profiler::Event> event;
+        for (int frame = 0; (frame < warmup + frames) && !app.IsReplayFinished(); frame++){
+            // Scripted input, and a restart after a game over, unless the
+            // keys come from a recording
+            if (replay.empty()){
+                if (!app.IsAnimating()){
+                    app.HandleKey(GLFW_KEY_R, GLFW_PRESS);
+                } else if ((frame % input_interval_g) == 0){
+                    app.HandleKey(input_script_g[(frame / input_interval_g) % input_script_size_g], GLFW_PRESS);
+                }
+            }
+
+            game::Profiler::Clear();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            app.RunFrame();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if (frame < warmup){
+                continue;
+            }
+            frame_time.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            stats.push_back(app.GetRenderStats());
+
+            // Total time of each zone in this frame; zones missing from the
+            // frame count as zero
+            int measured = frame_time.size();
+            game::Profiler::GetEvents(event);
+            for (int i = 0; i < event.size(); i++){
+                std::vector<double> &time = zone_time[event[i].name];
+                time.resize(measured, 0.0);
+                time.back() += (event[i].end - event[i].start)/1000000.0;
+            }
+        }
+        checksum = app.GetChecksum();
+    }
+    catch (std::exception &e){
+        std::cout.rdbuf(out_buffer);
+        PrintException(e);
+        return 1;
+    }
+    std::cout.rdbuf(out_buffer);
+
+    // A replay may end before the frame count
+    frames = frame_time.size();
+    if (frames == 0){
+        std::cerr << "No frame measured" << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!output.empty()){
+        file.open(output.c_str());
+        if (file.fail()){
+            std::cerr << "Error opening file " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+
+    // Results, with times in milliseconds
+    out << "{" << std::endl;
+    out << "  \"renderer\": \"" << renderer << "\"," << std::endl;
+    out << "  \"kernel\": \"" << game::TransformKernel::GetPathName(game::TransformKernel::GetPath()) << "\"," << std::endl;
+    out << "  \"seed\": " << seed << "," << std::endl;
+    out << "  \"stress_nodes\": " << stress_nodes << "," << std::endl;
+    out << "  \"stress_depth\": " << stress_depth << "," << std::endl;
+    out << "  \"warmup\": " << warmup << "," << std::endl;
+    out << "  \"frames\": " << frames << "," << std::endl;
+    out << "  \"checksum\": \"" << std::hex << checksum << std::dec << "\"," << std::endl;
+    out << "  \"frame_time_ms\": ";
+    WriteStats(out, frame_time);
+    out << "," << std::endl;
+    std::vector<double> present_interval;
+    for (int i = 0; i < stats.size(); i++){
+        present_interval.push_back(stats[i].present_interval);
+    }
+    out << "  \"present_interval_ms\": ";
+    WriteStats(out, present_interval);
+    out << "," << std::endl;
+    out << "  \"zone_time_ms\": {";
+    for (std::map<std::string, std::vector<double> >::iterator it = zone_time.begin(); it != zone_time.end(); it++){
+        it->second.resize(frames, 0.0);
+        out << (it == zone_time.begin() ? "" : ",") << std::endl << "    \"" << it->first << "\": ";
+        WriteStats(out, it->second);
+    }
+    out << std::endl << "  }," << std::endl;
+    out << "  \"render_stats\": {";
+    for (int i = 0; i < num_stats_g; i++){
+        std::vector<double> count;
+        for (int j = 0; j < stats.size(); j++){
+            count.push_back(stats[j].*stats_g[i].count);
+        }
+        out << (i == 0 ? "" : ",") << std::endl << "    \"" << stats_g[i].name << "\": ";
+        WriteStats(out, count);
+    }
+    out << std::endl << "  }" << std::endl;
+    out << "}" << std::endl;
+
+    return 0;
+}
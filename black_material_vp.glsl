@@ -1,4 +1,7 @@
 #version 130
+#ifdef FRAME_BLOCK
+#extension GL_ARB_uniform_buffer_object : require
+#endif
 
 // Vertex buffer
 in vec3 vertex;
@@ -6,9 +9,31 @@ in vec3 normal;
 in vec3 color;
 
 // Uniform (global) buffer
+#ifdef INSTANCED
+// Per-instance world transformation, streamed from the instance buffer
+in mat4 instance_world_mat;
+#define world_mat instance_world_mat
+#else
 uniform mat4 world_mat;
+#endif
+#ifdef FRAME_BLOCK
+// Per-frame globals, shared by all materials through one uniform buffer
+layout(std140) uniform FrameBlock {
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 view_projection_mat;
+    vec4 camera_position;
+    float timer;
+};
+#else
 uniform mat4 view_mat;
+#endif
+#ifdef INSTANCED
+in mat4 instance_normal_mat;
+#define normal_mat instance_normal_mat
+#else
 uniform mat4 normal_mat;
+#endif
 
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
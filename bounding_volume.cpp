@@ -0,0 +1,165 @@
+#include <cmath>
+#include <limits>
+
+#include "bounding_volume.h"
+
+namespace game {
+
+BoundingBox ComputeBoundingBox(const GLfloat *vertex, GLuint vertex_num, int vertex_att){
+
+    BoundingBox box;
+    box.min = glm::vec3(std::numeric_limits<float>::max());
+    box.max = glm::vec3(-std::numeric_limits<float>::max());
+    for (GLuint i = 0; i < vertex_num; i++){
+        glm::vec3 position(vertex[i*vertex_att], vertex[i*vertex_att + 1], vertex[i*vertex_att + 2]);
+        box.min = glm::min(box.min, position);
+        box.max = glm::max(box.max, position);
+    }
+    return box;
+}
+
+
+BoundingSphere ComputeBoundingSphere(const GLfloat *vertex, GLuint vertex_num, int vertex_att, const BoundingBox &box){
+
+    BoundingSphere sphere;
+    sphere.center = 0.5f*(box.min + box.max);
+    sphere.radius = 0.0;
+    for (GLuint i = 0; i < vertex_num; i++){
+        glm::vec3 position(vertex[i*vertex_att], vertex[i*vertex_att + 1], vertex[i*vertex_att + 2]);
+        sphere.radius = glm::max(sphere.radius, glm::length(position - sphere.center));
+    }
+    return sphere;
+}
+
+
+BoundingSphere EmptySphere(void){
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(0.0, 0.0, 0.0);
+    sphere.radius = -1.0;
+    return sphere;
+}
+
+
+BoundingSphere InfiniteSphere(void){
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(0.0, 0.0, 0.0);
+    sphere.radius = std::numeric_limits<float>::infinity();
+    return sphere;
+}
+
+
+BoundingSphere MergeSpheres(const BoundingSphere &a, const BoundingSphere &b){
+
+    // Empty and infinite spheres absorb or are absorbed by anything
+    if (a.radius < 0.0 || std::isinf(b.radius)){
+        return b;
+    }
+    if (b.radius < 0.0 || std::isinf(a.radius)){
+        return a;
+    }
+
+    // One sphere contains the other
+    float distance = glm::length(b.center - a.center);
+    if (distance + b.radius <= a.radius){
+        return a;
+    }
+    if (distance + a.radius <= b.radius){
+        return b;
+    }
+
+    // Sphere spanning the far sides of both spheres
+    BoundingSphere sphere;
+    sphere.radius = 0.5f*(distance + a.radius + b.radius);
+    sphere.center = a.center + (b.center - a.center)*((sphere.radius - a.radius) / distance);
+    return sphere;
+}
+
+
+BoundingSphere TransformSphere(const BoundingSphere &sphere, const glm::mat4 &transf){
+
+    if (sphere.radius < 0.0 || std::isinf(sphere.radius)){
+        return sphere;
+    }
+
+    // Largest scaling factor of the transformation
+    float scale = glm::max(glm::length(glm::vec3(transf[0])),
+                  glm::max(glm::length(glm::vec3(transf[1])),
+                           glm::length(glm::vec3(transf[2]))));
+
+    BoundingSphere result;
+    result.center = glm::vec3(transf * glm::vec4(sphere.center, 1.0));
+    result.radius = sphere.radius * scale;
+    return result;
+}
+
+
+Frustum::Frustum(void){
+
+    // Planes that never reject anything
+    for (int i = 0; i < 6; i++){
+        plane_[i] = glm::vec4(0.0, 0.0, 0.0, 1.0);
+    }
+}
+
+
+void Frustum::SetFromMatrix(const glm::mat4 &view_projection){
+
+    // Each plane is the sum or difference of the last row of the matrix
+    // with one of the others (Gribb and Hartmann)
+    // Note that in glm, the reference for matrix entries is of the form
+    // matrix[column][row]
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++){
+        row[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    }
+    plane_[0] = row[3] + row[0]; // Left
+    plane_[1] = row[3] - row[0]; // Right
+    plane_[2] = row[3] + row[1]; // Bottom
+    plane_[3] = row[3] - row[1]; // Top
+    plane_[4] = row[3] + row[2]; // Near
+    plane_[5] = row[3] - row[2]; // Far
+
+    // Normalize the planes so that distances are in world units
+    for (int i = 0; i < 6; i++){
+        plane_[i] /= glm::length(glm::vec3(plane_[i]));
+    }
+}
+
+
+bool Frustum::IsOutside(const BoundingSphere &sphere) const {
+
+    if (sphere.radius < 0.0){
+        return true;
+    }
+    for (int i = 0; i < 6; i++){
+        if (glm::dot(glm::vec3(plane_[i]), sphere.center) + plane_[i][3] < -sphere.radius){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool Frustum::IsOutside(const BoundingBox &box, const glm::mat4 &transf) const {
+
+    // Transformed box is centered at the transformed center, and its
+    // extent along a plane normal is the sum of its projected half axes
+    glm::vec3 center = glm::vec3(transf * glm::vec4(0.5f*(box.min + box.max), 1.0));
+    glm::vec3 half = 0.5f*(box.max - box.min);
+    glm::vec3 axis[3];
+    for (int j = 0; j < 3; j++){
+        axis[j] = glm::vec3(transf[j]) * half[j];
+    }
+    for (int i = 0; i < 6; i++){
+        glm::vec3 normal = glm::vec3(plane_[i]);
+        float extent = fabs(glm::dot(normal, axis[0])) + fabs(glm::dot(normal, axis[1])) + fabs(glm::dot(normal, axis[2]));
+        if (glm::dot(normal, center) + plane_[i][3] < -extent){
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace game
@@ -0,0 +1,61 @@
+#ifndef BOUNDING_VOLUME_H_
+#define BOUNDING_VOLUME_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+namespace game {
+
+    // Axis-aligned box in the coordinate frame of a mesh
+    struct BoundingBox {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Sphere enclosing a mesh or a whole subtree of the scene
+    // A negative radius marks an empty sphere, and an infinite radius a
+    // volume that is never culled
+    struct BoundingSphere {
+        glm::vec3 center;
+        float radius;
+    };
+
+    // Bounds of the vertex positions of an interleaved vertex buffer,
+    // where the position is stored in the first three floats of each vertex
+    BoundingBox ComputeBoundingBox(const GLfloat *vertex, GLuint vertex_num, int vertex_att);
+    // Sphere around the center of the box that encloses all the vertices
+    BoundingSphere ComputeBoundingSphere(const GLfloat *vertex, GLuint vertex_num, int vertex_att, const BoundingBox &box);
+
+    // Sphere that contains nothing, and sphere that is always visible
+    BoundingSphere EmptySphere(void);
+    BoundingSphere InfiniteSphere(void);
+    // Smallest sphere containing the two given spheres
+    BoundingSphere MergeSpheres(const BoundingSphere &a, const BoundingSphere &b);
+    // Sphere transformed by an affine transformation
+    // Non-uniform scaling grows the radius by the largest factor
+    BoundingSphere TransformSphere(const BoundingSphere &sphere, const glm::mat4 &transf);
+
+    // Six planes of a view volume, pointing inwards
+    class Frustum {
+
+        public:
+            Frustum(void);
+
+            // Extract the planes of a projection * view matrix
+            void SetFromMatrix(const glm::mat4 &view_projection);
+
+            // Check if a volume is completely outside of one of the planes
+            // The box is given in the frame of a world transformation
+            bool IsOutside(const BoundingSphere &sphere) const;
+            bool IsOutside(const BoundingBox &box, const glm::mat4 &transf) const;
+
+        private:
+            glm::vec4 plane_[6]; // Normal (xyz) and distance (w) of the planes
+
+    }; // class Frustum
+
+} // namespace game
+
+#endif // BOUNDING_VOLUME_H_
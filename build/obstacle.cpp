@@ -32,10 +32,13 @@ namespace game {
 
 	int Obstacle::GetScoreValue() { return scoreValue; }
 
+	void Obstacle::SetFollowPath(bool followPath) { followPath_ = followPath; }
+
 	void Obstacle::Update(float deltaTime) {
 
 		//Logic for controlling the obstacles position.
 			//Interpolate position between start and end.
+		if (!followPath_) { return; }
 
 		// lifeTime_ += deltaTime
 		lifeTime_ += deltaTime;
@@ -42,7 +42,11 @@ namespace game {
 
 //Add additional member functions here as needed to increase functionality.
 
-		void Update(float deltaTime); //Signature may need to be changed depending on how movement is implemented.
+		// Overrides SceneNode::Update, called once per simulation step
+		virtual void Update(float deltaTime);
+
+		// Move along the path from the start point to the end point
+		void SetFollowPath(bool followPath);
 
 	private:
 		//The Player should only ever move in the x y plane.
@@ -55,6 +59,7 @@ namespace game {
 		glm::vec3 currentPosition_; //The cureent linearly interpolated position of the obstacle.
 
 		float lifeTime_ = 0.0;
+		bool followPath_ = false; //Path motion is off until the paths are tuned
 
 		//AABB info
 		float xMax_;
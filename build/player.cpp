@@ -1,4 +1,5 @@
 #include "player.h"
+#include "../profiler.h"
 #include <iostream>
 
 namespace game {
@@ -63,7 +64,14 @@ namespace game {
 
 
 
-	void Player::Update(double deltaTime) {
+	float Player::GetSimTime() { return simTime_; }
+
+
+
+	void Player::Update(float deltaTime) {
+		PROFILE_ZONE("Player update");
+		simTime_ += deltaTime;
+
 		// Lane positions: Left = -0.9, Center = 0.0, Right = 0.9
 		float lanePositions[3] = {-0.9f, 0.0f, 0.9f};
 		targetX_ = lanePositions[currentLane_];
@@ -75,14 +83,13 @@ namespace game {
 		float newX = currentPos.x + (targetX_ - currentPos.x) * 15.0f * deltaTime;
 
 		// AUTOMATIC FORWARD MOVEMENT
-		forwardSpeed_ += forwardSpeedIncrease_;
+		forwardSpeed_ += forwardAcceleration_ * deltaTime;
 		float newZ = currentPos.z - forwardSpeed_ * deltaTime;  // Move in negative Z direction
 
 		// Jump physics
 		float newY = 0.5f;
 		if (isJumping_) {
-			double currentTime = glfwGetTime();
-			float timeSinceJump = currentTime - jumpStartTime_;
+			float timeSinceJump = simTime_ - jumpStartTime_;
 
 			if (timeSinceJump < jumpDuration_) {
 				// Parabolic jump arc using sine wave
@@ -96,8 +103,7 @@ namespace game {
 		}
 
 		if (isSliding_) {
-			double currentTime = glfwGetTime();
-			float timeSinceSlide = currentTime - slideStartTime_;
+			float timeSinceSlide = simTime_ - slideStartTime_;
 
 			if (timeSinceSlide < slideDuration_) {
 				// Parabolic jump arc using sine wave
@@ -115,7 +121,12 @@ namespace game {
 
 		// Update player position
 		SetPosition(glm::vec3(newX, newY, newZ));
-		SetScore(1); //Each update tick increment the player's score by 1
+		//Score one point per interval, whatever the simulation rate
+		scoreTime_ += deltaTime;
+		while (scoreTime_ >= scoreInterval_) {
+			SetScore(1);
+			scoreTime_ -= scoreInterval_;
+		}
 		//std::cout << "current score is: " << GetScore() << std::endl;
 	}
 }
\ No newline at end of file
@@ -47,7 +47,11 @@ namespace game {
 		float GetyMin();
 		//Add additional member functions here as needed to increase functionality.
 
-		void Update(double deltaTime); //Signature may need to be changed depending on how movement is implemented.
+		// Overrides SceneNode::Update, called once per simulation step
+		virtual void Update(float deltaTime);
+
+		// Simulation time seen by the player, used to time jumps and slides
+		float GetSimTime();
 
 	private:
 		bool cameraViewMode_ = true; //false for 1st person|true for 3rd person //Do we even need this???
@@ -66,7 +70,10 @@ namespace game {
 		float yMin_;
 
 		float forwardSpeed_ = 17.0f;
-		float forwardSpeedIncrease_ = 0.0025f;
+		float forwardAcceleration_ = 0.15f;	//Units per second, per second (was 0.0025 per frame at 60 fps)
+		float simTime_ = 0.0f;	//Sum of the simulation steps
+		float scoreTime_ = 0.0f;	//Time not turned into points yet
+		const float scoreInterval_ = 1.0f / 60.0f;	//One point per interval (was one per frame at 60 fps)
 		float health_;	//Number of 'hits' before being caught.
 		int score_ = 0;	//Culmulative point total.
 
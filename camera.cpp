@@ -10,6 +10,9 @@
 namespace game {
 
 Camera::Camera(void){
+
+    time_ = 0.0;
+    frame_block_buffer_ = 0;
 }
 
 
@@ -122,18 +125,61 @@ void Camera::SetProjection(GLfloat fov, GLfloat near, GLfloat far, GLfloat w, GL
 }
 
 
-void Camera::SetupShader(GLuint program){
+void Camera::SetupFrame(float time){
 
-    // Update view matrix
+    // Update view matrix once for the whole frame
     SetupViewMatrix();
+    time_ = time;
+
+    if (!(GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object)){
+        return;
+    }
+
+    FrameBlock block;
+    block.view_mat = view_matrix_;
+    block.projection_mat = projection_matrix_;
+    block.view_projection_mat = projection_matrix_ * view_matrix_;
+    block.camera_position = glm::vec4(position_, 1.0);
+    block.timer = time;
+
+    // Orphan the previous contents so the upload does not wait for the
+    // draws of the last frame
+    if (frame_block_buffer_ == 0){
+        glGenBuffers(1, &frame_block_buffer_);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, frame_block_buffer_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &block);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frame_block_binding_g, frame_block_buffer_);
+}
+
+
+bool Camera::HasFrameBlock(void) const {
+
+    return frame_block_buffer_ != 0;
+}
+
+
+void Camera::SetupShader(const MaterialProgram *program, GLState *gl_state) const {
 
     // Set view matrix in shader
-    GLint view_mat = glGetUniformLocation(program, "view_mat");
-    glUniformMatrix4fv(view_mat, 1, GL_FALSE, glm::value_ptr(view_matrix_));
+    GLint view_mat = program->GetUniform(ViewMatUniform);
+    gl_state->UniformMatrix4fv(view_mat, glm::value_ptr(view_matrix_));
     
     // Set projection matrix in shader
-    GLint projection_mat = glGetUniformLocation(program, "projection_mat");
-    glUniformMatrix4fv(projection_mat, 1, GL_FALSE, glm::value_ptr(projection_matrix_));
+    GLint projection_mat = program->GetUniform(ProjectionMatUniform);
+    gl_state->UniformMatrix4fv(projection_mat, glm::value_ptr(projection_matrix_));
+
+    // Set time in shader
+    gl_state->Uniform1f(program->GetUniform(TimerUniform), time_);
+}
+
+
+Frustum Camera::GetFrustum(void) const {
+
+    Frustum frustum;
+    frustum.SetFromMatrix(projection_matrix_ * view_matrix_);
+    return frustum;
 }
 
 
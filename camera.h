@@ -6,6 +6,9 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "material_program.h"
+#include "bounding_volume.h"
+#include "gl_state.h"
 
 namespace game {
 
@@ -45,8 +48,17 @@ namespace game {
             // Set projection from frustum parameters: field-of-view,
             // near and far planes, and width and height of viewport
             void SetProjection(GLfloat fov, GLfloat near, GLfloat far, GLfloat w, GLfloat h);
-            // Set all camera-related variables in shader program
-            void SetupShader(GLuint program);
+            // Compute the view for a new frame and upload the per-frame
+            // uniform block shared by all materials
+            void SetupFrame(float time);
+            // Whether the frame set up uploaded the uniform block, which
+            // needs uniform buffer objects (OpenGL 3.1)
+            bool HasFrameBlock(void) const;
+            // Set all camera-related variables in a shader program that
+            // does not use the per-frame uniform block
+            void SetupShader(const MaterialProgram *program, GLState *gl_state) const;
+            // Get the view volume of the camera for the current frame
+            Frustum GetFrustum(void) const;
 
         private:
             glm::vec3 position_; // Position of camera
@@ -55,6 +67,19 @@ namespace game {
             glm::vec3 side_; // Initial side vector
             glm::mat4 view_matrix_; // View matrix
             glm::mat4 projection_matrix_; // Projection matrix
+            float time_; // Time of the current frame
+            GLuint frame_block_buffer_; // Uniform buffer with the per-frame globals
+
+            // Per-frame globals, laid out as the std140 FrameBlock of
+            // the shaders
+            struct FrameBlock {
+                glm::mat4 view_mat;
+                glm::mat4 projection_mat;
+                glm::mat4 view_projection_mat;
+                glm::vec4 camera_position;
+                GLfloat timer;
+                GLfloat padding[3];
+            };
 
             // Create view matrix from current camera parameters
             void SetupViewMatrix(void);
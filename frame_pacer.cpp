@@ -0,0 +1,142 @@
+#include <stdexcept>
+#include <thread>
+
+#include "frame_pacer.h"
+
+namespace game {
+
+// Rate of the frames while idle, in Hz
+const double idle_rate_g = 30.0;
+// Time before a deadline spent spinning instead of sleeping, since
+// sleeps can overshoot by about a scheduler tick
+const std::chrono::microseconds spin_time_g(2000);
+
+// Names of the modes, in the order of the enum
+const char *pacing_mode_name_g[] = { "vsync", "adaptive", "capped", "uncapped" };
+const int num_pacing_modes_g = sizeof(pacing_mode_name_g)/sizeof(pacing_mode_name_g[0]);
+
+
+FramePacer::FramePacer(void){
+
+    mode_ = Uncapped;
+    rate_ = 60.0;
+    deadline_ = std::chrono::steady_clock::now();
+    last_present_ = deadline_;
+    present_interval_ = 0.0;
+    presented_ = false;
+}
+
+
+FramePacer::~FramePacer(){
+}
+
+
+void FramePacer::SetMode(Mode mode, double rate, bool has_window){
+
+    if (rate <= 0.0){
+        throw(std::invalid_argument(std::string("Invalid frame rate")));
+    }
+    mode_ = mode;
+    rate_ = rate;
+    deadline_ = std::chrono::steady_clock::now();
+    if (!has_window){
+        return;
+    }
+
+    // Adaptive vsync lets late frames tear instead of waiting for the
+    // next blank; it is requested with a negative swap interval
+    if ((mode_ == AdaptiveVSync) && !glfwExtensionSupported("GLX_EXT_swap_control_tear") && !glfwExtensionSupported("WGL_EXT_swap_control_tear")){
+        mode_ = VSync;
+    }
+    if (mode_ == VSync){
+        glfwSwapInterval(1);
+    } else if (mode_ == AdaptiveVSync){
+        glfwSwapInterval(-1);
+    } else {
+        glfwSwapInterval(0);
+    }
+}
+
+
+FramePacer::Mode FramePacer::GetMode(void) const {
+
+    return mode_;
+}
+
+
+double FramePacer::GetRate(void) const {
+
+    return rate_;
+}
+
+
+void FramePacer::Wait(bool idle){
+
+    // Period of the frames, or 0 when nothing holds them back
+    double period = 0.0;
+    if (mode_ == Capped){
+        period = 1.0/rate_;
+    }
+    if (idle && (period < 1.0/idle_rate_g)){
+        period = 1.0/idle_rate_g;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (period == 0.0){
+        deadline_ = now;
+        return;
+    }
+
+    // Each frame is due one period after the previous one, so that the
+    // rate holds on average; after a long frame, start over from now
+    // instead of rushing to catch up
+    std::chrono::steady_clock::duration step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(period));
+    deadline_ += step;
+    if (deadline_ + step < now){
+        deadline_ = now;
+        return;
+    }
+
+    // Sleep for most of the wait, then spin up to the deadline
+    if (deadline_ - now > spin_time_g){
+        std::this_thread::sleep_for(deadline_ - now - spin_time_g);
+    }
+    while (std::chrono::steady_clock::now() < deadline_){
+        std::this_thread::yield();
+    }
+}
+
+
+void FramePacer::Presented(void){
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (presented_){
+        present_interval_ = std::chrono::duration<double, std::milli>(now - last_present_).count();
+    }
+    last_present_ = now;
+    presented_ = true;
+}
+
+
+double FramePacer::GetPresentInterval(void) const {
+
+    return present_interval_;
+}
+
+
+const char *FramePacer::GetModeName(Mode mode){
+
+    return pacing_mode_name_g[mode];
+}
+
+
+FramePacer::Mode FramePacer::GetModeFromName(const std::string &name){
+
+    for (int i = 0; i < num_pacing_modes_g; i++){
+        if (name == pacing_mode_name_g[i]){
+            return (Mode) i;
+        }
+    }
+    throw(std::invalid_argument(std::string("Unknown pacing mode ")+name));
+}
+
+} // namespace game
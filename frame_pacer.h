@@ -0,0 +1,56 @@
+#ifndef FRAME_PACER_H_
+#define FRAME_PACER_H_
+
+#include <chrono>
+#include <string>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace game {
+
+    // Control of the frame rate: wait for the vertical blank, cap the
+    // rate by sleeping then spinning up to each deadline, or run as fast
+    // as possible
+    // While the game is idle (e.g., paused), frames are also held to a
+    // low rate, so that the loop does not keep a core busy
+    class FramePacer {
+
+        public:
+            enum Mode { VSync, AdaptiveVSync, Capped, Uncapped };
+
+            FramePacer(void);
+            ~FramePacer();
+
+            // Select a mode, with the target rate of the capped mode in Hz
+            // The swap interval is set on the current context when there
+            // is a window; without one, both vsync modes run uncapped
+            // Adaptive vsync falls back to vsync when the driver lacks it
+            void SetMode(Mode mode, double rate, bool has_window);
+            Mode GetMode(void) const;
+            double GetRate(void) const;
+
+            // Wait until the next frame is due; call it before presenting
+            void Wait(bool idle);
+            // Note that a frame was presented; call it right after
+            void Presented(void);
+            // Time between the last two presents, in milliseconds, or 0
+            double GetPresentInterval(void) const;
+
+            // Names of the modes: vsync, adaptive, capped and uncapped
+            static const char *GetModeName(Mode mode);
+            static Mode GetModeFromName(const std::string &name);
+
+        private:
+            Mode mode_;
+            double rate_; // Target rate of the capped mode
+            std::chrono::steady_clock::time_point deadline_; // Due time of the last frame
+            std::chrono::steady_clock::time_point last_present_;
+            double present_interval_;
+            bool presented_; // Whether a frame was presented yet
+
+    }; // class FramePacer
+
+} // namespace game
+
+#endif // FRAME_PACER_H_
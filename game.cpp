@@ -3,6 +3,9 @@
 #include <sstream>
 
 #include "game.h"
+#include "profiler.h"
+#include "static_batcher.h"
+#include "transform_kernel.h"
 #include "build/path_config.h"
 
 namespace game {
@@ -25,30 +28,82 @@ glm::vec3 camera_position_g(0.0, 3.0, 7.0); //Default = (0.0, 0.0, 50.0)
 glm::vec3 camera_look_at_g(0.0, 0.0, -3.5);
 glm::vec3 camera_up_g(0.0, 1.0, 0.0);
 
+// Simulation settings
+const unsigned int random_seed_g = 5489; // Default seed of std::mt19937
+const double simulation_rate_g = 120.0; // Fixed simulation steps per second
+const double max_frame_time_g = 0.25; // Longest time simulated in one frame
+
+// Stress scene: meshes, materials and textures the asteroids cycle
+// through, and the extent of the field in front of the track
+const char *stress_mesh_g[] = { "SimpleSphereMesh", "CubeMesh", "CylinderMesh", "ConeMesh" };
+const char *stress_material_g[] = { "ObjectMaterial", "RedMaterial", "TexturedMaterial" };
+const char *stress_texture_g[] = { "ObstacleTexture", "TreeTexture", "BuildingTexture" };
+const int num_stress_meshes_g = sizeof(stress_mesh_g)/sizeof(stress_mesh_g[0]);
+const int num_stress_materials_g = sizeof(stress_material_g)/sizeof(stress_material_g[0]);
+const int num_stress_textures_g = sizeof(stress_texture_g)/sizeof(stress_texture_g[0]);
+const float stress_field_size_g = 600.0;
+const float stress_link_size_g = 4.0; // Extent of a child around its parent in a chain
+const float stress_spin_g = 6.0; // Fastest spin, in half turns per second
+
 // Materials 
 const std::string material_directory_g = MATERIAL_DIRECTORY;
 
+// Textures of the scenery and obstacles, and their image files in the
+// material directory
+const char *texture_name_g[] = { "GroundTexture", "ObstacleTexture", "LaneDividerTexture", "TreeTexture", "BuildingTexture", "TunnelTexture" };
+const char *texture_file_g[] = { "ground_texture.png", "obstacle_texture.png", "lane_divider_texture.png", "tree_texture.png", "building_texture.png", "tunnel_texture.png" };
+const int num_textures_g = sizeof(texture_name_g)/sizeof(texture_name_g[0]);
+
+// File the profiler trace is written to
+const std::string trace_file_g = "trace.json";
+
 
 Game::Game(void){
 
     // Don't do work in the constructor, leave it for the Init() function
+    window_ = NULL;
+    headless_ = false;
+    stress_nodes_ = 0;
+    stress_depth_ = 1;
+    replaying_ = false;
+    tick_ = 0;
 }
 
 
-void Game::Init(void){
+void Game::Init(bool headless){
 
     // Run all initialization steps
+    headless_ = headless;
+    frame_limit_ = 0;
     InitWindow();
     InitView();
-    InitEventHandlers();
+    if (!headless_){
+        InitEventHandlers();
+    }
 
     // Set variables
     animating_ = true;
+    print_culling_ = false;
+    print_gpu_ = false;
+    fixed_frame_time_ = 0.0;
+    fixed_clock_ = 0.0;
+    SetSeed(random_seed_g);
+    SetSimulationRate(simulation_rate_g);
+    SetPacing(headless_ ? FramePacer::Uncapped : FramePacer::VSync);
 }
 
        
 void Game::InitWindow(void){
 
+    // Without a window, only an OpenGL context is needed
+    if (headless_){
+        headless_context_.Init();
+        start_time_ = std::chrono::steady_clock::now();
+        InitExtensions();
+        headless_context_.InitFramebuffer(window_width_g, window_height_g);
+        return;
+    }
+
     // Initialize the window management library (GLFW)
     if (!glfwInit()){
         throw(GameException(std::string("Could not initialize the GLFW library")));
@@ -68,10 +123,23 @@ void Game::InitWindow(void){
     // Make the window's context the current one
     glfwMakeContextCurrent(window_);
 
+    InitExtensions();
+}
+
+
+void Game::InitExtensions(void){
+
     // Initialize the GLEW library to access OpenGL extensions
     // Need to do it after initializing an OpenGL context
     glewExperimental = GL_TRUE;
     GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX also looks for an X display, after loading the
+    // OpenGL functions; there is none with an EGL context
+    if (headless_ && (err == GLEW_ERROR_NO_GLX_DISPLAY)){
+        err = GLEW_OK;
+    }
+#endif
     if (err != GLEW_OK){
         throw(GameException(std::string("Could not initialize the GLEW library: ")+std::string((const char *) glewGetErrorString(err))));
     }
@@ -86,7 +154,12 @@ void Game::InitView(void){
 
     // Set viewport
     int width, height;
-    glfwGetFramebufferSize(window_, &width, &height);
+    if (headless_){
+        width = headless_context_.GetWidth();
+        height = headless_context_.GetHeight();
+    } else {
+        glfwGetFramebufferSize(window_, &width, &height);
+    }
     glViewport(0, 0, width, height);
 
     // Set up camera
@@ -110,45 +183,39 @@ void Game::InitEventHandlers(void){
 
 void Game::SetupResources(void){
 
+    // Queue textures for game objects first, so that their images are
+    // decoded on worker threads while meshes and shaders are built here
+    std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/player_texture.png");
+    player_texture_ = resman_.QueueTexture("PlayerTexture", filename.c_str());
+
+    for (int i = 0; i < num_textures_g; i++){
+        filename = std::string(MATERIAL_DIRECTORY) + std::string("/") + std::string(texture_file_g[i]);
+        resman_.QueueTexture(texture_name_g[i], filename.c_str());
+    }
+
     resman_.CreateCube("CubeMesh");
 
     // Create parts to use for capsule shaped model.
-    resman_.CreateSphere("SphereMesh");
+    sphere_mesh_ = resman_.CreateSphere("SphereMesh");
     resman_.CreateCylindricalGeometry("CylinderMesh");
     resman_.CreateCylindricalGeometry("ConeMesh", 0.0);
+    resman_.UploadTextures();
 
     // Load material to be applied to mechanical arm
-    std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/shiny_blue");
+    filename = std::string(MATERIAL_DIRECTORY) + std::string("/shiny_blue");
     resman_.LoadResource(Material, "ObjectMaterial", filename.c_str());
+    resman_.UploadTextures();
 
     filename = std::string(MATERIAL_DIRECTORY) + std::string("/red_material");
-    resman_.LoadResource(Material, "RedMaterial", filename.c_str());
+    red_material_ = resman_.LoadMaterial("RedMaterial", filename.c_str());
+    resman_.UploadTextures();
 
     // Load textured material shader
     filename = std::string(MATERIAL_DIRECTORY) + std::string("/textured_material");
-    resman_.LoadResource(Material, "TexturedMaterial", filename.c_str());
-
-    // Load textures for game objects
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/player_texture.png");
-    resman_.LoadResource(Texture, "PlayerTexture", filename.c_str());
-
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/ground_texture.png");
-    resman_.LoadResource(Texture, "GroundTexture", filename.c_str());
-
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/obstacle_texture.png");
-    resman_.LoadResource(Texture, "ObstacleTexture", filename.c_str());
-
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/lane_divider_texture.png");
-    resman_.LoadResource(Texture, "LaneDividerTexture", filename.c_str());
-
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/tree_texture.png");
-    resman_.LoadResource(Texture, "TreeTexture", filename.c_str());
-
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/building_texture.png");
-    resman_.LoadResource(Texture, "BuildingTexture", filename.c_str());
+    textured_material_ = resman_.LoadMaterial("TexturedMaterial", filename.c_str());
 
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/tunnel_texture.png");
-    resman_.LoadResource(Texture, "TunnelTexture", filename.c_str());
+    // Upload the remaining textures once decoded
+    resman_.FinishTextures();
 }
 
 
@@ -665,6 +732,21 @@ void Game::SetupScene(void){
     root_->AddChild(treeTrunk10_);
     treeTrunk10_->AddChild(treeTop10_);
 
+    // Trees never change shape, so each trunk and its top are baked
+    // into one mesh and drawn at once; trees whose top has its own
+    // texture are left as they are
+    StaticBatcher batcher(&resman_);
+    Obstacle *trees[] = {treeTrunk1_, treeTrunk2_, treeTrunk3_, treeTrunk4_, treeTrunk5_,
+                         treeTrunk6_, treeTrunk7_, treeTrunk8_, treeTrunk9_, treeTrunk10_};
+    for (int i = 0; i < 10; i++){
+        batcher.Bake(trees[i], trees[i]->GetName() + std::string("Mesh"));
+    }
+
+    // Extra load for stress tests
+    if (stress_nodes_ > 0){
+        CreateAsteroidField(stress_nodes_, stress_depth_);
+    }
+
     scene_.SetRoot(root_);
 
 }
@@ -682,138 +764,353 @@ float map_angle(float current_time, float cycle_length, float max_angle){
 
 void Game::MainLoop(void){
 
-    // Loop while the user did not close the window
-    while (!glfwWindowShouldClose(window_)){
-        // Animate the scene
-        if (animating_){
-            static double last_time = 0;
-            double current_time = glfwGetTime();
-            float deltaTime = current_time - last_time;
-            if (deltaTime > 0.01){
-                // Update player movement and jumping
-                if (player_root_) {
-                    player_root_->Update(deltaTime);
-
-                    // CAMERA FOLLOWS PLAYER
-                    glm::vec3 playerPos = player_root_->GetPosition();
-                    glm::vec3 cameraPos = playerPos + glm::vec3(0.0, 3.0, 7.0);  // Behind and above player
-                    glm::vec3 cameraLookAt = playerPos + glm::vec3(0.0, 0.0, -3.5);  // Look slightly ahead
-                    camera_.SetView(cameraPos, cameraLookAt, camera_up_g);
-
-                    // INFINITE GROUND
-                    // Keep ground centered on player's Z position
-                    float playerZ = playerPos.z;
-                    ground_plane_->SetPosition(glm::vec3(0.0, -0.5, playerZ - 240.0));
-                    lane_divider_1_->SetPosition(glm::vec3(-0.47, -0.4, playerZ - 240.0));
-                    lane_divider_2_->SetPosition(glm::vec3( 0.47, -0.4, playerZ - 240.0));
-                }
+    // Start the simulation clock
+    ResetClock();
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    int frame = 0;
+
+    // Loop while the user did not close the window, the frame limit is
+    // not reached, and a replay did not end
+    while ((headless_ || !glfwWindowShouldClose(window_)) && ((frame_limit_ == 0) || (frame < frame_limit_)) && !IsReplayFinished()){
+        RunFrame();
+        frame++;
+    }
+
+    // Without a window, the frame rate is the only visible result
+    if (headless_ && (frame > 0)){
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        std::cout << "Rendered " << frame << " frames in " << elapsed << " s ("
+                  << 1000.0*elapsed/frame << " ms per frame)" << std::endl;
+    }
+}
+
+
+void Game::ResetClock(void){
+
+    fixed_clock_ = 0.0;
+    last_time_ = GetTime();
+    accumulator_ = 0.0;
+}
+
+
+void Game::RunFrame(void){
+
+    PROFILE_ZONE("Frame");
+
+    // A fixed clock moves by the same time every frame
+    fixed_clock_ += fixed_frame_time_;
+
+    // Keys replayed while the simulation is stopped, e.g., a restart
+    ReplayKeys();
+
+    // Animate the scene: run as many fixed simulation steps as needed to
+    // catch up with the clock
+    double current_time = GetTime();
+    double frame_time = current_time - last_time_;
+    last_time_ = current_time;
+    if (animating_){
+        PROFILE_ZONE("Simulation");
+        // After a long stall, drop time instead of running many steps
+        accumulator_ += glm::min(frame_time, max_frame_time_g);
+        while (animating_ && (accumulator_ >= time_step_)){
+            scene_.BeginStep();
+            Step(time_step_);
+            accumulator_ -= time_step_;
+            tick_++;
+            // Keys that arrived after this step, as they were recorded
+            ReplayKeys();
+        }
+    }
+
+    // Draw the nodes between the last two steps, by the fraction of a
+    // step left in the accumulator
+    scene_.SetBlend(animating_ ? accumulator_ / time_step_ : 1.0);
+
+    // CAMERA FOLLOWS PLAYER, at its interpolated position
+    if (player_root_) {
+        PROFILE_ZONE("Camera follow");
+        glm::vec3 playerPos = glm::vec3(player_root_->GetWorldTransform()[3]);
+        glm::vec3 cameraPos = playerPos + glm::vec3(0.0, 3.0, 7.0);  // Behind and above player
+        glm::vec3 cameraLookAt = playerPos + glm::vec3(0.0, 0.0, -3.5);  // Look slightly ahead
+        camera_.SetView(cameraPos, cameraLookAt, camera_up_g);
+    }
+
+    // Draw the scene
+    {
+        PROFILE_ZONE("Draw");
+        scene_.Draw(&camera_, (float) current_time);
+    }
+    if (print_culling_){
+        std::cout << "visible " << scene_.GetVisibleNodes() << ", culled " << scene_.GetCulledNodes()
+                  << " (" << scene_.GetCulledSubtrees() << " subtrees), gl calls dropped "
+                  << scene_.GetGLState().GetHits() << ", issued " << scene_.GetGLState().GetMisses() << std::endl;
+    }
+    if (print_gpu_){
+        scene_.GetGpuTimer().Report(std::cout);
+    }
+
+    // Hold the frame until it is due; paused games run at a low rate
+    {
+        PROFILE_ZONE("Pacing");
+        pacer_.Wait(!animating_ && !headless_);
+    }
+
+    if (headless_){
+        // Nothing to display, but finish the frame like a swap would
+        PROFILE_ZONE("Present");
+        headless_context_.Present();
+        UpdateStats();
+        return;
+    }
+
+    // Push buffer drawn in the background onto the display
+    {
+        PROFILE_ZONE("Swap buffers");
+        glfwSwapBuffers(window_);
+    }
+    UpdateStats();
+
+    // Update other events like input handling
+    PROFILE_ZONE("Poll events");
+    glfwPollEvents();
+}
+
+
+void Game::SetFixedFrameTime(double frame_time){
+
+    fixed_frame_time_ = frame_time;
+}
+
+
+bool Game::IsAnimating(void) const {
+
+    return animating_;
+}
+
+
+unsigned int Game::GetChecksum(void) const {
+
+    return scene_.GetChecksum();
+}
+
+
+const RenderStats &Game::GetRenderStats(void) const {
+
+    return stats_;
+}
+
+
+void Game::UpdateStats(void){
+
+    pacer_.Presented();
+    stats_ = scene_.GetRenderStats();
+    stats_.present_interval = pacer_.GetPresentInterval();
+}
+
+
+void Game::StartRecording(const std::string &filename){
+
+    InputLog::Header header;
+    header.seed = seed_;
+    header.time_step = time_step_;
+    header.stress_nodes = stress_nodes_;
+    header.stress_depth = stress_depth_;
+    input_log_.Create(filename, header);
+}
+
+
+void Game::StartReplay(const std::string &filename){
+
+    // Same settings as the recorded session
+    input_log_.Load(filename);
+    const InputLog::Header &header = input_log_.GetHeader();
+    SetSeed(header.seed);
+    time_step_ = header.time_step;
+    SetStressScene(header.stress_nodes, header.stress_depth);
+    replaying_ = true;
+}
+
+
+bool Game::IsReplayFinished(void) const {
+
+    return replaying_ && input_log_.IsFinished(tick_);
+}
+
 
-                // Update scene (obstacles moving)
-                scene_.Update();
-
-                // INFINITE OBSTACLES - Respawn obstacles ahead when they go behind player!
-                if (player_root_) {
-                    float playerZ = player_root_->GetPosition().z;
-                    float respawnDistance = 200.0f;  // Respawn 100 units ahead
-                    float despawnThreshold = 20.0f;  // Despawn when 20 units behind
-
-                    // Check each obstacle and respawn if needed
-                    Obstacle* obstacles[] = {obstacle1_, obstacle2_, obstacle3_, obstacle4_, obstacle5_,
-                                            obstacle6_, obstacle7_, obstacle8_, obstacle9_, obstacle10_,
-                                            obstacle11_, obstacle12_, obstacle13_, obstacle14_, obstacle15_,
-                                            coin1_, coin2_, coin3_, coin4_, coin5_, 
-                                            treeTrunk1_, treeTrunk2_, treeTrunk3_, treeTrunk4_ , treeTrunk5_,
-                                            treeTrunk6_, treeTrunk7_, treeTrunk8_, treeTrunk9_ , treeTrunk10_};
-                    float lanePositions[] = {-0.9f, 0.0f, 0.9f};  // Left, Center, Right
-
-                    for (int i = 0; i < 30; i++) {
-                        if (obstacles[i]) {
-                            float obstacleZ = obstacles[i]->GetPosition().z;
-
-                            // if (obstacleZ - playerZ <= 0) or somthin
-                            //    aabb collision check
-                            //std::cout << "playerZ = " << playerZ << std::endl;
-                            //std::cout << "obstacleZ = " << obstacleZ << std::endl;
-                            //std::cout << "obstacleZ - playerZ = " << obstacleZ - playerZ << std::endl;
-
-                            if (playerZ > obstacleZ && obstacleZ > playerZ - 0.5) {
-                                //std::cout << "TTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\nTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\nTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\n";
-                                if (AABBcheck(player_root_, obstacles[i])) {
-                                    if (i <= 14) {
-                                        player_root_->SetGeometry(resman_.GetResource("SphereMesh"));
-                                        player_root_->SetShader(resman_.GetResource("RedMaterial"));
-                                        animating_ = false;
-                                        std::cout << "GAME OVER\nYour final score is: " << player_root_->GetScore() << std::endl;
-                                        //std::cout << "bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\nbonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\nbonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\n";
-                                    }
-                                    else if (i <= 19) {
-                                        player_root_->SetScore(obstacles[i]->GetScoreValue());
-                                        //std::cout << "Player just scored 10pts!!!\n";
-
-                                        // Randomly assign to a lane
-                                        int randomLane = rand() % 3;
-                                        float x = lanePositions[randomLane];
-
-                                        // Respawn ahead of player
-                                        float newZ = playerZ - respawnDistance - (rand() % 50);
-                                        obstacles[i]->SetPosition(glm::vec3(x, obstacles[i]->GetPosition()[1], newZ));
-                                        //obstacles[i]->SetScale(glm::vec3(0.6f, scaleY, 0.6f)); //Suspecting this will cause frustration with setting up AABBs
-                                        obstacles[i]->SetStartPoint(glm::vec3(x, obstacles[i]->GetPosition()[1], newZ));
-                                        obstacles[i]->SetEndPoint(glm::vec3(x, obstacles[i]->GetPosition()[1], playerZ + 50.0f));
-                                    }
-
-                                }
-                            }
-
-                            // If obstacle has gone behind player, respawn it ahead
-                            if (obstacleZ > playerZ + despawnThreshold) {
-                                if (obstacles[i] == obstacles[0]) {
-                                    //std::cout << "obstacle1_ just despawned! obstacle1_ just despawned! obstacle1_ just despawned! obstacle1_ just despawned!\n";
-                                }
-
-                                if(i <= 19){
-                                    // Randomly assign to a lane
-                                    int randomLane = rand() % 3;
-                                    float x = lanePositions[randomLane];
-
-                                    // Randomly choose full height or half height
-                                    bool fullHeight = (rand() % 2 == 0);
-                                    float y = fullHeight ? 0.6f : 0.3f;
-                                    float scaleY = fullHeight ? 1.2f : 0.6f;
-
-                                    // Respawn ahead of player
-                                    float newZ = playerZ - respawnDistance - (rand() % 50);
-                                    obstacles[i]->SetPosition(glm::vec3(x, obstacles[i]->GetPosition().y, newZ));
-                                    //obstacles[i]->SetScale(glm::vec3(0.6f, scaleY, 0.6f)); //Suspecting this will cause frustration with setting up AABBs
-                                    obstacles[i]->SetStartPoint(glm::vec3(x, obstacles[i]->GetPosition().y, newZ));
-                                    obstacles[i]->SetEndPoint(glm::vec3(x, obstacles[i]->GetPosition().y, playerZ + 50.0f));
-                                }
-                                else {
-                                    int switchSides = (rand() % 2 == 1)?-1:1;
-                                    float newZ = playerZ - respawnDistance - (rand() % 50);
-                                    obstacles[i]->SetPosition(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, newZ));
-                                    obstacles[i]->SetStartPoint(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, newZ));
-                                    obstacles[i]->SetEndPoint(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, playerZ + 50.0f));
-                                }
-                            }
+void Game::ReplayKeys(void){
+
+    if (!replaying_){
+        return;
+    }
+    InputLog::Event event;
+    while (input_log_.Next(tick_, event)){
+        HandleKey(event.key, event.action);
+    }
+}
+
+
+void Game::SetSeed(unsigned int seed){
+
+    seed_ = seed;
+    random_.seed(seed);
+}
+
+
+int Game::RandomInt(int n){
+
+    return random_() % n;
+}
+
+
+float Game::RandomFloat(void){
+
+    // 24 bits, which a float holds exactly
+    return (random_() >> 8) / 16777216.0f;
+}
+
+
+glm::vec3 Game::RandomVector(void){
+
+    float x = RandomFloat();
+    float y = RandomFloat();
+    float z = RandomFloat();
+    return glm::vec3(x, y, z);
+}
+
+
+void Game::SetFrameLimit(int frames){
+
+    frame_limit_ = frames;
+}
+
+
+double Game::GetTime(void) const {
+
+    if (fixed_frame_time_ > 0.0){
+        return fixed_clock_;
+    }
+    if (headless_){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    }
+    return glfwGetTime();
+}
+
+
+void Game::Step(float delta_time){
+
+    // Update all nodes: player movement and jumping, obstacles moving
+    scene_.Update(delta_time);
+
+    // INFINITE GROUND
+    // Keep ground centered on player's Z position
+    if (player_root_) {
+        float playerZ = player_root_->GetPosition().z;
+        ground_plane_->SetPosition(glm::vec3(0.0, -0.5, playerZ - 240.0));
+        lane_divider_1_->SetPosition(glm::vec3(-0.47, -0.4, playerZ - 240.0));
+        lane_divider_2_->SetPosition(glm::vec3( 0.47, -0.4, playerZ - 240.0));
+    }
+
+    // INFINITE OBSTACLES - Respawn obstacles ahead when they go behind player!
+    if (player_root_) {
+        PROFILE_ZONE("Collision");
+        float playerZ = player_root_->GetPosition().z;
+        float respawnDistance = 200.0f;  // Respawn 100 units ahead
+        float despawnThreshold = 20.0f;  // Despawn when 20 units behind
+
+        // Check each obstacle and respawn if needed
+        Obstacle* obstacles[] = {obstacle1_, obstacle2_, obstacle3_, obstacle4_, obstacle5_,
+                                obstacle6_, obstacle7_, obstacle8_, obstacle9_, obstacle10_,
+                                obstacle11_, obstacle12_, obstacle13_, obstacle14_, obstacle15_,
+                                coin1_, coin2_, coin3_, coin4_, coin5_, 
+                                treeTrunk1_, treeTrunk2_, treeTrunk3_, treeTrunk4_ , treeTrunk5_,
+                                treeTrunk6_, treeTrunk7_, treeTrunk8_, treeTrunk9_ , treeTrunk10_};
+        float lanePositions[] = {-0.9f, 0.0f, 0.9f};  // Left, Center, Right
+
+        for (int i = 0; i < 30; i++) {
+            if (obstacles[i]) {
+                float obstacleZ = obstacles[i]->GetPosition().z;
+
+                // if (obstacleZ - playerZ <= 0) or somthin
+                //    aabb collision check
+                //std::cout << "playerZ = " << playerZ << std::endl;
+                //std::cout << "obstacleZ = " << obstacleZ << std::endl;
+                //std::cout << "obstacleZ - playerZ = " << obstacleZ - playerZ << std::endl;
+
+                if (playerZ > obstacleZ && obstacleZ > playerZ - 0.5) {
+                    //std::cout << "TTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\nTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\nTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTT\n";
+                    if (AABBcheck(player_root_, obstacles[i])) {
+                        if (i <= 14) {
+                            player_root_->SetGeometry(resman_.GetResource(sphere_mesh_));
+                            player_root_->SetShader(resman_.GetResource(red_material_));
+                            animating_ = false;
+                            std::cout << "GAME OVER\nYour final score is: " << player_root_->GetScore() << std::endl;
+                            //std::cout << "bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\nbonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\nbonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk - bonk\n";
                         }
+                        else if (i <= 19) {
+                            player_root_->SetScore(obstacles[i]->GetScoreValue());
+                            //std::cout << "Player just scored 10pts!!!\n";
+
+                            // Randomly assign to a lane
+                            int randomLane = RandomInt(3);
+                            float x = lanePositions[randomLane];
+
+                            // Respawn ahead of player
+                            float newZ = playerZ - respawnDistance - (RandomInt(50));
+                            obstacles[i]->Teleport(glm::vec3(x, obstacles[i]->GetPosition()[1], newZ));
+                            //obstacles[i]->SetScale(glm::vec3(0.6f, scaleY, 0.6f)); //Suspecting this will cause frustration with setting up AABBs
+                            obstacles[i]->SetStartPoint(glm::vec3(x, obstacles[i]->GetPosition()[1], newZ));
+                            obstacles[i]->SetEndPoint(glm::vec3(x, obstacles[i]->GetPosition()[1], playerZ + 50.0f));
+                        }
+
                     }
                 }
 
-                // Update timer
-                last_time = current_time;
+                // If obstacle has gone behind player, respawn it ahead
+                if (obstacleZ > playerZ + despawnThreshold) {
+                    if (obstacles[i] == obstacles[0]) {
+                        //std::cout << "obstacle1_ just despawned! obstacle1_ just despawned! obstacle1_ just despawned! obstacle1_ just despawned!\n";
+                    }
+
+                    if(i <= 19){
+                        // Randomly assign to a lane
+                        int randomLane = RandomInt(3);
+                        float x = lanePositions[randomLane];
+
+                        // Randomly choose full height or half height
+                        bool fullHeight = (RandomInt(2) == 0);
+                        float y = fullHeight ? 0.6f : 0.3f;
+                        float scaleY = fullHeight ? 1.2f : 0.6f;
+
+                        // Respawn ahead of player
+                        float newZ = playerZ - respawnDistance - (RandomInt(50));
+                        obstacles[i]->Teleport(glm::vec3(x, obstacles[i]->GetPosition().y, newZ));
+                        //obstacles[i]->SetScale(glm::vec3(0.6f, scaleY, 0.6f)); //Suspecting this will cause frustration with setting up AABBs
+                        obstacles[i]->SetStartPoint(glm::vec3(x, obstacles[i]->GetPosition().y, newZ));
+                        obstacles[i]->SetEndPoint(glm::vec3(x, obstacles[i]->GetPosition().y, playerZ + 50.0f));
+                    }
+                    else {
+                        int switchSides = (RandomInt(2) == 1)?-1:1;
+                        float newZ = playerZ - respawnDistance - (RandomInt(50));
+                        obstacles[i]->Teleport(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, newZ));
+                        obstacles[i]->SetStartPoint(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, newZ));
+                        obstacles[i]->SetEndPoint(glm::vec3(switchSides * obstacles[i]->GetPosition().x, obstacles[i]->GetPosition().y, playerZ + 50.0f));
+                    }
+                }
             }
         }
+    }
+}
 
-        // Draw the scene
-        scene_.Draw(&camera_);
 
-        // Push buffer drawn in the background onto the display
-        glfwSwapBuffers(window_);
+void Game::SetPacing(FramePacer::Mode mode, double rate){
 
-        // Update other events like input handling
-        glfwPollEvents();
-    }
+    pacer_.SetMode(mode, rate, window_ != NULL);
+}
+
+
+void Game::SetSimulationRate(double rate){
+
+    time_step_ = 1.0 / rate;
 }
 
 
@@ -823,80 +1120,147 @@ void Game::KeyCallback(GLFWwindow* window, int key, int scancode, int action, in
     void* ptr = glfwGetWindowUserPointer(window);
     Game *game = (Game *) ptr;
 
+    // Keys come from the recording during a replay
+    if (!game->replaying_){
+        game->HandleKey(key, action);
+    }
+}
+
+
+void Game::HandleKey(int key, int action){
+
+    // Keys can arrive through the callback of GLFW, which exceptions must
+    // not cross, so errors of the debug outputs are only printed
+    if (input_log_.IsRecording()){
+        try {
+            input_log_.Write(tick_, key, action);
+        }
+        catch (std::exception &e){
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
     // Quit game if 'q' is pressed
-    if (key == GLFW_KEY_Q && action == GLFW_PRESS){
-        glfwSetWindowShouldClose(window, true);
+    if (key == GLFW_KEY_Q && action == GLFW_PRESS && window_){
+        glfwSetWindowShouldClose(window_, true);
     }
 
     if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-        game->player_root_->SetShader(game->resman_.GetResource("TexturedMaterial"));
-        game->player_root_->SetTexture(game->resman_.GetResource("PlayerTexture"));
-        game->player_root_->Reset();
-
-        Obstacle* obstacles[] = { game->obstacle1_, game->obstacle2_, game->obstacle3_, game->obstacle4_, game->obstacle5_,
-                                  game->obstacle6_, game->obstacle7_, game->obstacle8_, game->obstacle9_, game->obstacle10_,
-                                  game->obstacle11_, game->obstacle12_, game->obstacle13_, game->obstacle14_, game->obstacle15_,
-                                  game->coin1_, game->coin2_, game->coin3_, game->coin4_, game->coin5_ };
+        player_root_->SetShader(resman_.GetResource(textured_material_));
+        player_root_->SetTexture(resman_.GetResource(player_texture_));
+        player_root_->Reset();
+
+        Obstacle* obstacles[] = { obstacle1_, obstacle2_, obstacle3_, obstacle4_, obstacle5_,
+                                  obstacle6_, obstacle7_, obstacle8_, obstacle9_, obstacle10_,
+                                  obstacle11_, obstacle12_, obstacle13_, obstacle14_, obstacle15_,
+                                  coin1_, coin2_, coin3_, coin4_, coin5_ };
         float lanePositions[] = { -0.9f, 0.0f, 0.9f };
-        float playerZ = game->player_root_->GetPosition().z;
+        float playerZ = player_root_->GetPosition().z;
         float respawnDistance = 200.0f;
         for (int i = 0; i < 19; i++) {
             // Randomly assign to a lane
-            int randomLane = rand() % 3;
+            int randomLane = RandomInt(3);
             float x = lanePositions[randomLane];
 
             // Randomly choose full height or half height
-            bool fullHeight = (rand() % 2 == 0);
+            bool fullHeight = (RandomInt(2) == 0);
             float y = fullHeight ? 0.6f : 0.3f;
             float scaleY = fullHeight ? 1.2f : 0.6f;
 
             // Respawn ahead of player
-            float newZ = playerZ - respawnDistance - (rand() % 50);
+            float newZ = playerZ - respawnDistance - (RandomInt(50));
             obstacles[i]->SetPosition(glm::vec3(x, obstacles[i]->GetPosition().y, newZ + (i * 70)));
             obstacles[i]->SetStartPoint(glm::vec3(x, obstacles[i]->GetPosition().y, newZ + (i * 70)));
             obstacles[i]->SetEndPoint(glm::vec3(x, obstacles[i]->GetPosition().y, playerZ + 50.0f));
         }
 
-        game->animating_ = true;
+        animating_ = true;
+    }
+
+    // Print the number of visible and culled nodes, and the calls the
+    // state cache dropped, every frame while 'c' is toggled on
+    // The occupancy of the geometry arena is printed once when toggled on
+    if (key == GLFW_KEY_C && action == GLFW_PRESS){
+        print_culling_ = !print_culling_;
+        if (print_culling_){
+            resman_.GetGeometryArena().Report(std::cout);
+            std::cout << "Transform kernel: " << TransformKernel::GetPathName(TransformKernel::GetPath()) << std::endl;
+        }
+    }
+
+    // Print the GPU time of the clear and of each material every frame
+    // while 'g' is toggled on
+    if (key == GLFW_KEY_G && action == GLFW_PRESS){
+        print_gpu_ = !print_gpu_;
+        if (print_gpu_ && !scene_.GetGpuTimer().IsSupported()){
+            std::cout << "GPU timer queries are not supported" << std::endl;
+        }
+    }
+
+    // Print what the last frame submitted when 'f' is pressed
+    if (key == GLFW_KEY_F && action == GLFW_PRESS){
+        stats_.Report(std::cout);
+    }
+
+    // Switch to the next pacing mode when 'v' is pressed, skipping modes
+    // the driver falls back from
+    if (key == GLFW_KEY_V && action == GLFW_PRESS){
+        FramePacer::Mode mode = pacer_.GetMode();
+        do {
+            mode = (FramePacer::Mode) ((mode + 1) % (FramePacer::Uncapped + 1));
+            SetPacing(mode, pacer_.GetRate());
+        } while (pacer_.GetMode() != mode);
+        std::cout << "Pacing: " << FramePacer::GetModeName(pacer_.GetMode()) << std::endl;
+    }
+
+    // Write the timing zones recorded so far when 't' is pressed
+    if (key == GLFW_KEY_T && action == GLFW_PRESS){
+        try {
+            Profiler::WriteTrace(trace_file_g);
+            std::cout << "Trace written to " << trace_file_g << std::endl;
+        }
+        catch (std::exception &e){
+            std::cerr << e.what() << std::endl;
+        }
     }
 
     // Stop animation if space bar is pressed
     if (key == GLFW_KEY_SPACE && action == GLFW_PRESS){
-        game->animating_ = (game->animating_ == true) ? false : true;
+        animating_ = (animating_ == true) ? false : true;
     }
 
     // === PLAYER CONTROLS ===
-    if (game->player_root_) {
+    if (player_root_) {
         // LEFT ARROW or A - Move to left lane
         if ((key == GLFW_KEY_LEFT || key == GLFW_KEY_A || key == GLFW_KEY_J) && action == GLFW_PRESS){
-            if (game->player_root_->currentLane_ > 0){
-                game->player_root_->currentLane_--;
-                //std::cout << "Moving to LEFT lane " << game->player_root_->currentLane_ << std::endl;
+            if (player_root_->currentLane_ > 0){
+                player_root_->currentLane_--;
+                //std::cout << "Moving to LEFT lane " << player_root_->currentLane_ << std::endl;
             }
         }
 
         // RIGHT ARROW or D - Move to right lane
         if ((key == GLFW_KEY_RIGHT || key == GLFW_KEY_D || key == GLFW_KEY_L) && action == GLFW_PRESS){
-            if (game->player_root_->currentLane_ < 2){
-                game->player_root_->currentLane_++;
-                //std::cout << "Moving to RIGHT lane " << game->player_root_->currentLane_ << std::endl;
+            if (player_root_->currentLane_ < 2){
+                player_root_->currentLane_++;
+                //std::cout << "Moving to RIGHT lane " << player_root_->currentLane_ << std::endl;
             }
         }
 
         // UP ARROW or W - Jump
         if ((key == GLFW_KEY_UP || key == GLFW_KEY_W || key == GLFW_KEY_I) && action == GLFW_PRESS){
-            if (!game->player_root_->isJumping_){
-                game->player_root_->isJumping_ = true;
-                game->player_root_->jumpStartTime_ = glfwGetTime();
+            if (!player_root_->isJumping_){
+                player_root_->isJumping_ = true;
+                player_root_->jumpStartTime_ = player_root_->GetSimTime();
                 //std::cout << "JUMP!" << std::endl;
             }
         }
 
         // DOWN ARROW or S - Jump
         if ((key == GLFW_KEY_DOWN || key == GLFW_KEY_S || key == GLFW_KEY_K) && action == GLFW_PRESS) {
-            if (!game->player_root_->isSliding_) {
-                game->player_root_->isSliding_ = true;
-                game->player_root_->slideStartTime_ = glfwGetTime();
+            if (!player_root_->isSliding_) {
+                player_root_->isSliding_ = true;
+                player_root_->slideStartTime_ = player_root_->GetSimTime();
                 //std::cout << "SLIDE!" << std::endl;
             }
         }
@@ -917,7 +1281,10 @@ void Game::ResizeCallback(GLFWwindow* window, int width, int height){
 
 Game::~Game(){
     
-    glfwTerminate();
+    input_log_.Close(tick_);
+    if (!headless_){
+        glfwTerminate();
+    }
 }
 
 
@@ -936,14 +1303,23 @@ Asteroid *Game::CreateAsteroidInstance(std::string entity_name, std::string obje
 
     // Create asteroid instance
     Asteroid *ast = new Asteroid(entity_name, geom, mat);
-    //scene_.AddNode(ast);
     return ast;
 }
 
 
-void Game::CreateAsteroidField(int num_asteroids){
+void Game::CreateAsteroidField(int num_asteroids, int depth){
+
+    // Low-detail sphere, shared by all spherical asteroids
+    if (!resman_.GetResource("SimpleSphereMesh")){
+        resman_.CreateSphere("SimpleSphereMesh", 0.8, 12, 6);
+    }
+
+    // The field hangs from its own node under the root
+    SceneNode *field = new SceneNode("AsteroidField", NULL, NULL);
+    root_->AddChild(field);
 
     // Create a number of asteroid instances
+    SceneNode *parent = field;
     for (int i = 0; i < num_asteroids; i++){
         // Create instance name
         std::stringstream ss;
@@ -951,15 +1327,50 @@ void Game::CreateAsteroidField(int num_asteroids){
         std::string index = ss.str();
         std::string name = "AsteroidInstance" + index;
 
-        // Create asteroid instance
-        Asteroid *ast = CreateAsteroidInstance(name, "SimpleSphereMesh", "ObjectMaterial");
+        // Create asteroid instance, with a random mix of meshes and
+        // materials
+        int mesh = RandomInt(num_stress_meshes_g);
+        int material = RandomInt(num_stress_materials_g);
+        Asteroid *ast = CreateAsteroidInstance(name, stress_mesh_g[mesh], stress_material_g[material]);
+        if (std::string(stress_material_g[material]) == "TexturedMaterial"){
+            ast->SetTexture(resman_.GetResource(stress_texture_g[RandomInt(num_stress_textures_g)]));
+        }
+
+        // Chains of the given depth: the first asteroid of a chain is
+        // placed in the field, and each of the others near the previous one
+        if ((i % depth) == 0){
+            parent = field;
+        }
+        parent->AddChild(ast);
 
         // Set attributes of asteroid: random position, orientation, and
         // angular momentum
-        ast->SetPosition(glm::vec3(-300.0 + 600.0*((float) rand() / RAND_MAX), -300.0 + 600.0*((float) rand() / RAND_MAX), 600.0*((float) rand() / RAND_MAX)));
-        ast->SetOrientation(glm::normalize(glm::angleAxis(glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX)))));
-        ast->SetAngM(glm::normalize(glm::angleAxis(0.05f*glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX)))));
+        // Each random number is drawn in its own statement, so that the
+        // sequence does not depend on the evaluation order of arguments
+        glm::vec3 position = RandomVector();
+        if (parent == field){
+            ast->SetPosition(stress_field_size_g*(position - glm::vec3(0.5, 0.5, 1.0)));
+        } else {
+            ast->SetPosition(stress_link_size_g*(position - glm::vec3(0.5, 0.5, 0.5)));
+        }
+        float angle = RandomFloat();
+        glm::vec3 axis = RandomVector();
+        ast->SetOrientation(glm::normalize(glm::angleAxis(glm::pi<float>()*angle, axis)));
+        angle = RandomFloat();
+        axis = RandomVector();
+        ast->SetAngM(stress_spin_g*glm::pi<float>()*angle*glm::normalize(axis));
+        parent = ast;
+    }
+}
+
+
+void Game::SetStressScene(int num_nodes, int depth){
+
+    if ((num_nodes < 0) || (depth < 1)){
+        throw(GameException(std::string("Invalid size of stress scene")));
     }
+    stress_nodes_ = num_nodes;
+    stress_depth_ = depth;
 }
 
 
@@ -1,12 +1,17 @@
 #ifndef GAME_H_
 #define GAME_H_
 
+#include <chrono>
 #include <exception>
+#include <random>
 #include <string>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "frame_pacer.h"
+#include "headless_context.h"
+#include "input_log.h"
 #include "scene_graph.h"
 #include "resource_manager.h"
 #include "camera.h"
@@ -35,24 +40,101 @@ namespace game {
             Game(void);
             ~Game();
             // Call Init() before calling any other method
-            void Init(void); 
+            // A headless game draws offscreen, without a window or input
+            void Init(bool headless = false); 
             // Set up resources for the game
             void SetupResources(void);
             // Set up initial scene
             void SetupScene(void);
+            // Add a field of spinning asteroids to the scene, with mixed
+            // meshes and materials, for stress tests
+            // Asteroids hang from the field in chains of the given depth,
+            // so a depth of 1 gives a flat hierarchy
+            // Call it before SetupScene(); 0 nodes for no field
+            void SetStressScene(int num_nodes, int depth = 1);
             // Run the game: keep the application active
             void MainLoop(void); 
+            // Number of fixed simulation steps per second
+            void SetSimulationRate(double rate);
+            // Stop the main loop after a number of frames (0 for no limit)
+            void SetFrameLimit(int frames);
+            // Pace the frames: vsync by default with a window, uncapped
+            // when headless; the rate in Hz applies to the capped mode
+            void SetPacing(FramePacer::Mode mode, double rate = 60.0);
+
+            // Drive the game one frame at a time, instead of MainLoop()
+            // Restart the simulation clock before the first frame
+            void ResetClock(void);
+            // Run the simulation steps due, then draw and present a frame
+            void RunFrame(void);
+            // React to a key, as if it came from the window
+            void HandleKey(int key, int action);
+
+            // Reproducible runs: advance the clock by a fixed time every
+            // frame instead of following real time (0 for real time), and
+            // seed the random numbers used by the game
+            void SetFixedFrameTime(double frame_time);
+            void SetSeed(unsigned int seed);
+            // Whether the game is running (false after a game over)
+            bool IsAnimating(void) const;
+            // Hash of the state of the scene, to compare runs
+            unsigned int GetChecksum(void) const;
+            // What the last frame submitted
+            const RenderStats &GetRenderStats(void) const;
+
+            // Record the keys of the session, with the simulation step
+            // each one arrived before, and the seed and scene settings
+            // Call it after Init() and the other settings, and before
+            // SetupScene(); the recording ends with the game
+            void StartRecording(const std::string &filename);
+            // Play a recording back instead of taking input, with the
+            // seed, simulation rate and stress scene it was made with
+            // Call it after Init() and before SetupResources()
+            void StartReplay(const std::string &filename);
+            // Whether all keys of the replay were applied and the
+            // simulation reached the end of the recording
+            bool IsReplayFinished(void) const;
+
+            // Whether the bounding boxes of the player and an obstacle
+            // overlap in x and y
+            static bool AABBcheck(Player* player, Obstacle* obstacle);
 
         private:
-            // GLFW window
+            // GLFW window, or NULL when headless
             GLFWwindow* window_;
 
+            // Offscreen context used instead of the window when headless
+            // Declared before the members holding OpenGL objects, so that
+            // it is destroyed after them
+            bool headless_;
+            HeadlessContext headless_context_;
+            std::chrono::steady_clock::time_point start_time_; // Clock origin when headless
+            int frame_limit_;
+
+            // Size of the asteroid field added for stress tests
+            int stress_nodes_;
+            int stress_depth_;
+
+            // Input recorded or replayed, keyed to simulation steps
+            InputLog input_log_;
+            bool replaying_;
+            uint32_t tick_; // Simulation steps run so far
+            // Apply the replayed keys due before the next step
+            void ReplayKeys(void);
+
             // Scene graph containing all nodes to render
             SceneGraph scene_;
 
             // Resources available to the game
             ResourceManager resman_;
 
+            // Resources swapped on the player during play, kept as
+            // handles so that no name is looked up after setup
+            MeshHandle sphere_mesh_;
+            MaterialHandle red_material_;
+            MaterialHandle textured_material_;
+            TextureHandle player_texture_;
+
             // Camera abstraction
             Camera camera_;
 
@@ -62,6 +144,38 @@ namespace game {
             // Flag to turn animation on/off
             bool animating_;
 
+            // Flag to print culling results every frame
+            bool print_culling_;
+
+            // Flag to print GPU times every frame
+            bool print_gpu_;
+
+            // Frame rate control, and the counts of the last frame with
+            // its present interval
+            FramePacer pacer_;
+            RenderStats stats_;
+
+            // Fixed-step simulation clock
+            double time_step_; // Length of a simulation step, in seconds
+            double accumulator_; // Time not simulated yet
+            double last_time_; // Clock at the last frame
+            double fixed_frame_time_; // Time added every frame, or 0 for real time
+            double fixed_clock_; // Clock when the frame time is fixed
+
+            // Random numbers of the game, from a seeded generator
+            std::mt19937 random_;
+            unsigned int seed_;
+            int RandomInt(int n); // Between 0 and n - 1
+            float RandomFloat(void); // Between 0 and 1
+            glm::vec3 RandomVector(void); // Components between 0 and 1
+
+            // Advance the game by one simulation step
+            void Step(float delta_time);
+            // Seconds since the game started
+            double GetTime(void) const;
+            // Note a presented frame, and keep its counts
+            void UpdateStats(void);
+
             // Player - Blue Robot
             Player *player_root_;
             SceneNode *player_body_, *player_head_;
@@ -85,6 +199,7 @@ namespace game {
 
             // Methods to initialize the game
             void InitWindow(void);
+            void InitExtensions(void);
             void InitView(void);
             void InitEventHandlers(void);
  
@@ -95,14 +210,13 @@ namespace game {
             // Asteroid field
             // Create instance of one asteroid
             Asteroid *CreateAsteroidInstance(std::string entity_name, std::string object_name, std::string material_name);
-            // Create entire random asteroid field
-            void CreateAsteroidField(int num_asteroids = 1500);
+            // Create entire random asteroid field under the root, in chains
+            // of the given depth
+            void CreateAsteroidField(int num_asteroids = 1500, int depth = 1);
 
             // Create an instance of an object
             SceneNode *CreateInstance(std::string entity_name, std::string object_name, std::string material_name);
 
-            bool AABBcheck(Player* player, Obstacle* obstacle);
-
     }; // class Game
 
 } // namespace game
@@ -0,0 +1,307 @@
+#include <stdexcept>
+
+#include "geometry_arena.h"
+#include "resource.h"
+
+namespace game {
+
+// Initial size of the buffers, in elements
+// Both buffers double whenever a mesh does not fit
+const GLuint initial_vertex_capacity_g = 4096;
+const GLuint initial_index_capacity_g = 16384;
+// Number of floats per vertex in the interleaved vertex format
+const int vertex_att_g = 11;
+
+
+GeometryArena::GeometryArena(void){
+
+    vertex_pool_.target = GL_ARRAY_BUFFER;
+    vertex_pool_.buffer = 0;
+    vertex_pool_.element_size = vertex_att_g*sizeof(GLfloat);
+    vertex_pool_.capacity = 0;
+    vertex_pool_.used = 0;
+
+    index_pool_.target = GL_ELEMENT_ARRAY_BUFFER;
+    index_pool_.buffer = 0;
+    index_pool_.element_size = sizeof(GLuint);
+    index_pool_.capacity = 0;
+    index_pool_.used = 0;
+}
+
+
+GeometryArena::~GeometryArena(){
+}
+
+
+GeometryArena::Allocation GeometryArena::Allocate(const GLfloat *vertex, GLuint vertex_num, const GLuint *index, GLuint index_num){
+
+    // Buffers are created on first use, once there is an OpenGL context
+    if (vertex_pool_.buffer == 0){
+        Grow(vertex_pool_, initial_vertex_capacity_g);
+        Grow(index_pool_, initial_index_capacity_g);
+    }
+
+    Allocation allocation;
+    allocation.vertices = Reserve(vertex_pool_, vertex_num);
+    allocation.indices = Reserve(index_pool_, index_num);
+
+    // Without base-vertex draws, the indices must point directly at the
+    // vertices of the mesh in the shared buffer
+    std::vector<GLuint> offset_index;
+    const GLuint *upload_index = index;
+    if (UsesBaseVertex()){
+        allocation.base_vertex = allocation.vertices.first;
+    } else {
+        allocation.base_vertex = 0;
+        offset_index.assign(index, index + index_num);
+        for (GLuint i = 0; i < index_num; i++){
+            offset_index[i] += allocation.vertices.first;
+        }
+        upload_index = &offset_index[0];
+    }
+
+    // Binding the element buffer would modify the current vertex array
+    // object, so unbind it first
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_pool_.buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.vertices.first*vertex_pool_.element_size, vertex_num*vertex_pool_.element_size, vertex);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_pool_.buffer);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.indices.first*index_pool_.element_size, index_num*index_pool_.element_size, upload_index);
+
+    return allocation;
+}
+
+
+void GeometryArena::Free(const Allocation &allocation){
+
+    Release(vertex_pool_, allocation.vertices);
+    Release(index_pool_, allocation.indices);
+}
+
+
+void GeometryArena::Read(const Allocation &allocation, std::vector<GLfloat> &vertex, std::vector<GLuint> &index) const {
+
+    vertex.resize(allocation.vertices.count*vertex_att_g);
+    index.resize(allocation.indices.count);
+    if ((vertex.size() == 0) || (index.size() == 0)){
+        return;
+    }
+
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_pool_.buffer);
+    glGetBufferSubData(GL_ARRAY_BUFFER, allocation.vertices.first*vertex_pool_.element_size, allocation.vertices.count*vertex_pool_.element_size, &vertex[0]);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_pool_.buffer);
+    glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.indices.first*index_pool_.element_size, allocation.indices.count*index_pool_.element_size, &index[0]);
+
+    // Undo the offset applied on upload when there is no base vertex
+    if (allocation.base_vertex != (GLint) allocation.vertices.first){
+        for (int i = 0; i < index.size(); i++){
+            index[i] -= allocation.vertices.first;
+        }
+    }
+}
+
+
+GLuint GeometryArena::GetArrayBuffer(void) const {
+
+    return vertex_pool_.buffer;
+}
+
+
+GLuint GeometryArena::GetElementArrayBuffer(void) const {
+
+    return index_pool_.buffer;
+}
+
+
+GLuint GeometryArena::GetVertexArray(const MaterialProgram *program){
+
+    // Find the vertex array already configured for this layout
+    GLuint layout = program->GetLayout();
+    for (int i = 0; i < vertex_array_.size(); i++){
+        if (vertex_array_[i].layout == layout){
+            return vertex_array_[i].vao;
+        }
+    }
+
+    // First time a mesh is drawn with this layout
+    VertexArray va;
+    va.layout = layout;
+    va.program = program;
+    glGenVertexArrays(1, &va.vao);
+    glBindVertexArray(va.vao);
+    Resource::SetupVertexFormat(program, vertex_pool_.buffer, index_pool_.buffer);
+    glBindVertexArray(0);
+    vertex_array_.push_back(va);
+    return va.vao;
+}
+
+
+bool GeometryArena::UsesBaseVertex(void) const {
+
+    return GLEW_VERSION_3_2 || GLEW_ARB_draw_elements_base_vertex;
+}
+
+
+GLuint GeometryArena::GetVertexCapacity(void) const {
+
+    return vertex_pool_.capacity;
+}
+
+
+GLuint GeometryArena::GetVerticesUsed(void) const {
+
+    return vertex_pool_.used;
+}
+
+
+GLuint GeometryArena::GetIndexCapacity(void) const {
+
+    return index_pool_.capacity;
+}
+
+
+GLuint GeometryArena::GetIndicesUsed(void) const {
+
+    return index_pool_.used;
+}
+
+
+void GeometryArena::Report(std::ostream &out) const {
+
+    out << "Geometry arena" << std::endl;
+    ReportPool(out, "vertices", vertex_pool_);
+    ReportPool(out, "indices", index_pool_);
+}
+
+
+ArenaRange GeometryArena::Reserve(Pool &pool, GLuint count){
+
+    // First free range that is large enough
+    for (int i = 0; i < pool.free.size(); i++){
+        if (pool.free[i].count >= count){
+            ArenaRange range;
+            range.first = pool.free[i].first;
+            range.count = count;
+            pool.free[i].first += count;
+            pool.free[i].count -= count;
+            if (pool.free[i].count == 0){
+                pool.free.erase(pool.free.begin() + i);
+            }
+            pool.used += count;
+            return range;
+        }
+    }
+
+    // No range fits: at least double the buffer, and try again
+    GLuint capacity = pool.capacity*2;
+    if (capacity < pool.capacity + count){
+        capacity = pool.capacity + count;
+    }
+    Grow(pool, capacity);
+    return Reserve(pool, count);
+}
+
+
+void GeometryArena::Release(Pool &pool, const ArenaRange &range){
+
+    if (range.count == 0){
+        return;
+    }
+
+    // Insert in position order
+    int i = 0;
+    while ((i < pool.free.size()) && (pool.free[i].first < range.first)){
+        i++;
+    }
+    pool.free.insert(pool.free.begin() + i, range);
+    pool.used -= range.count;
+
+    // Merge with the next range, then with the previous one
+    if ((i + 1 < pool.free.size()) && (pool.free[i].first + pool.free[i].count == pool.free[i + 1].first)){
+        pool.free[i].count += pool.free[i + 1].count;
+        pool.free.erase(pool.free.begin() + i + 1);
+    }
+    if ((i > 0) && (pool.free[i - 1].first + pool.free[i - 1].count == pool.free[i].first)){
+        pool.free[i - 1].count += pool.free[i].count;
+        pool.free.erase(pool.free.begin() + i);
+    }
+}
+
+
+void GeometryArena::Grow(Pool &pool, GLuint capacity){
+
+    glBindVertexArray(0);
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(pool.target, buffer);
+    glBufferData(pool.target, capacity*pool.element_size, NULL, GL_STATIC_DRAW);
+
+    // Copy the current contents to the start of the new buffer
+    if (pool.buffer > 0){
+        GLsizeiptr size = pool.capacity*pool.element_size;
+        if (GLEW_VERSION_3_1 || GLEW_ARB_copy_buffer){
+            glBindBuffer(GL_COPY_READ_BUFFER, pool.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+        } else {
+            std::vector<char> data(size);
+            glBindBuffer(pool.target, pool.buffer);
+            glGetBufferSubData(pool.target, 0, size, &data[0]);
+            glBindBuffer(pool.target, buffer);
+            glBufferSubData(pool.target, 0, size, &data[0]);
+        }
+        glDeleteBuffers(1, &pool.buffer);
+    }
+
+    // The new space extends the last free range if it reaches the end
+    ArenaRange range;
+    range.first = pool.capacity;
+    range.count = capacity - pool.capacity;
+    if ((pool.free.size() > 0) && (pool.free.back().first + pool.free.back().count == pool.capacity)){
+        pool.free.back().count += range.count;
+    } else {
+        pool.free.push_back(range);
+    }
+
+    pool.buffer = buffer;
+    pool.capacity = capacity;
+
+    SetupVertexArrays();
+}
+
+
+void GeometryArena::SetupVertexArrays(void){
+
+    for (int i = 0; i < vertex_array_.size(); i++){
+        glBindVertexArray(vertex_array_[i].vao);
+        Resource::SetupVertexFormat(vertex_array_[i].program, vertex_pool_.buffer, index_pool_.buffer);
+    }
+    glBindVertexArray(0);
+}
+
+
+void GeometryArena::ReportPool(std::ostream &out, const char *name, const Pool &pool){
+
+    // Fragmentation is the share of free space outside of the largest
+    // free range, i.e. space that a large mesh could not use
+    GLuint free_total = 0, largest = 0;
+    for (int i = 0; i < pool.free.size(); i++){
+        free_total += pool.free[i].count;
+        if (pool.free[i].count > largest){
+            largest = pool.free[i].count;
+        }
+    }
+    float occupancy = (pool.capacity > 0) ? 100.0*pool.used/pool.capacity : 0.0;
+    float fragmentation = (free_total > 0) ? 100.0*(free_total - largest)/free_total : 0.0;
+
+    out << "  " << name << ": " << pool.used << " / " << pool.capacity << " used (" << occupancy << "%), "
+        << pool.free.size() << " free ranges, largest " << largest << ", fragmentation " << fragmentation << "%" << std::endl;
+}
+
+} // namespace game
@@ -0,0 +1,105 @@
+#ifndef GEOMETRY_ARENA_H_
+#define GEOMETRY_ARENA_H_
+
+#include <vector>
+#include <ostream>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "material_program.h"
+
+namespace game {
+
+    // Range of elements (vertices or indices) in a buffer of the arena
+    struct ArenaRange {
+        GLuint first;
+        GLuint count;
+    };
+
+    // One vertex buffer and one index buffer shared by all static meshes
+    // Meshes are suballocated with a first-fit free list, and drawn with
+    // a base vertex, so that the whole scene uses the same buffers and
+    // the same vertex array object for each material layout
+    class GeometryArena {
+
+        public:
+            // Place of a mesh in the arena
+            struct Allocation {
+                ArenaRange vertices;
+                ArenaRange indices;
+                // Value to add to the indices when drawing; 0 when the
+                // indices were offset on upload because base-vertex draws
+                // are not available
+                GLint base_vertex;
+            };
+
+            GeometryArena(void);
+            ~GeometryArena();
+
+            // Copy a mesh into the arena, growing the buffers if needed
+            // Vertices use the interleaved 11-float vertex format
+            Allocation Allocate(const GLfloat *vertex, GLuint vertex_num, const GLuint *index, GLuint index_num);
+            // Return the space of a mesh to the arena
+            void Free(const Allocation &allocation);
+            // Read a mesh back from the buffers, with indices relative to
+            // its first vertex
+            void Read(const Allocation &allocation, std::vector<GLfloat> &vertex, std::vector<GLuint> &index) const;
+
+            // Buffers of the arena (they change when the arena grows)
+            GLuint GetArrayBuffer(void) const;
+            GLuint GetElementArrayBuffer(void) const;
+            // Vertex array object for the attribute layout of a program,
+            // shared by all meshes of the arena
+            GLuint GetVertexArray(const MaterialProgram *program);
+
+            // Whether meshes are drawn with glDrawElementsBaseVertex
+            bool UsesBaseVertex(void) const;
+
+            // Occupancy of the buffers, in elements
+            GLuint GetVertexCapacity(void) const;
+            GLuint GetVerticesUsed(void) const;
+            GLuint GetIndexCapacity(void) const;
+            GLuint GetIndicesUsed(void) const;
+            // Print occupancy and fragmentation of both buffers
+            void Report(std::ostream &out) const;
+
+        private:
+            // Buffer of fixed-size elements with its free space
+            struct Pool {
+                GLenum target; // Buffer target used to upload data
+                GLuint buffer; // OpenGL buffer, or 0 before first use
+                GLsizeiptr element_size; // Size of one element in bytes
+                GLuint capacity; // Number of elements in the buffer
+                GLuint used; // Number of elements allocated
+                std::vector<ArenaRange> free; // Free ranges, sorted by position
+            };
+
+            // Vertex array object of one attribute layout
+            struct VertexArray {
+                GLuint layout;
+                const MaterialProgram *program; // Program it was created for
+                GLuint vao;
+            };
+
+            Pool vertex_pool_;
+            Pool index_pool_;
+            std::vector<VertexArray> vertex_array_;
+
+            // Take a range from the free list, growing the pool if no
+            // free range is large enough
+            ArenaRange Reserve(Pool &pool, GLuint count);
+            // Give a range back, merging it with its free neighbours
+            static void Release(Pool &pool, const ArenaRange &range);
+            // Move a pool to a larger buffer, keeping its contents
+            void Grow(Pool &pool, GLuint capacity);
+            // Point the vertex array objects at the current buffers
+            void SetupVertexArrays(void);
+            // Print the occupancy and fragmentation of one pool
+            static void ReportPool(std::ostream &out, const char *name, const Pool &pool);
+
+    }; // class GeometryArena
+
+} // namespace game
+
+#endif // GEOMETRY_ARENA_H_
@@ -0,0 +1,205 @@
+#include <cstring>
+
+#include "gl_state.h"
+
+namespace game {
+
+GLState::GLState(void){
+
+    current_uniform_ = NULL;
+    Invalidate();
+    ResetCounters();
+}
+
+
+GLState::~GLState(){
+}
+
+
+void GLState::Invalidate(void){
+
+    program_ = unknown_;
+    vertex_array_ = unknown_;
+    array_buffer_ = unknown_;
+    uniform_buffer_ = unknown_;
+    active_texture_ = unknown_;
+    for (int i = 0; i < num_texture_units_; i++){
+        texture_[i] = unknown_;
+    }
+    current_uniform_ = NULL;
+}
+
+
+void GLState::UseProgram(GLuint program){
+
+    if (Changed(program_, program)){
+        glUseProgram(program);
+        program_changes_++;
+        current_uniform_ = &uniform_[program];
+    }
+}
+
+
+void GLState::BindVertexArray(GLuint vertex_array){
+
+    if (Changed(vertex_array_, vertex_array)){
+        glBindVertexArray(vertex_array);
+    }
+}
+
+
+void GLState::BindBuffer(GLenum target, GLuint buffer){
+
+    GLuint *cached = NULL;
+    if (target == GL_ARRAY_BUFFER){
+        cached = &array_buffer_;
+    } else if (target == GL_UNIFORM_BUFFER){
+        cached = &uniform_buffer_;
+    }
+
+    if (!cached || Changed(*cached, buffer)){
+        glBindBuffer(target, buffer);
+    }
+}
+
+
+void GLState::ActiveTexture(GLenum unit){
+
+    if (Changed(active_texture_, unit)){
+        glActiveTexture(unit);
+    }
+}
+
+
+void GLState::BindTexture(GLenum target, GLuint texture){
+
+    // Only 2D textures of the first units are tracked
+    GLuint unit = active_texture_ - GL_TEXTURE0;
+    if ((target != GL_TEXTURE_2D) || (unit >= num_texture_units_)){
+        glBindTexture(target, texture);
+        misses_++;
+        texture_binds_++;
+        return;
+    }
+
+    if (Changed(texture_[unit], texture)){
+        glBindTexture(target, texture);
+        texture_binds_++;
+    }
+}
+
+
+void GLState::Uniform1i(GLint location, GLint value){
+
+    // Compare the bits of the integer
+    GLfloat v;
+    memcpy(&v, &value, sizeof(GLfloat));
+    if (Changed(location, &v, 1)){
+        glUniform1i(location, value);
+        uniform_uploads_++;
+    }
+}
+
+
+void GLState::Uniform1f(GLint location, GLfloat value){
+
+    if (Changed(location, &value, 1)){
+        glUniform1f(location, value);
+        uniform_uploads_++;
+    }
+}
+
+
+void GLState::UniformMatrix4fv(GLint location, const GLfloat *value){
+
+    if (Changed(location, value, 16)){
+        glUniformMatrix4fv(location, 1, GL_FALSE, value);
+        uniform_uploads_++;
+    }
+}
+
+
+int GLState::GetHits(void) const {
+
+    return hits_;
+}
+
+
+int GLState::GetMisses(void) const {
+
+    return misses_;
+}
+
+
+int GLState::GetProgramChanges(void) const {
+
+    return program_changes_;
+}
+
+
+int GLState::GetTextureBinds(void) const {
+
+    return texture_binds_;
+}
+
+
+int GLState::GetUniformUploads(void) const {
+
+    return uniform_uploads_;
+}
+
+
+void GLState::ResetCounters(void){
+
+    hits_ = 0;
+    misses_ = 0;
+    program_changes_ = 0;
+    texture_binds_ = 0;
+    uniform_uploads_ = 0;
+}
+
+
+bool GLState::Changed(GLuint &cached, GLuint value){
+
+    if (cached == value){
+        hits_++;
+        return false;
+    }
+    cached = value;
+    misses_++;
+    return true;
+}
+
+
+bool GLState::Changed(GLint location, const GLfloat *value, int count){
+
+    // Inactive uniforms are ignored by OpenGL anyway
+    if (location < 0){
+        hits_++;
+        return false;
+    }
+    // Without a known program the value cannot be tracked
+    if (!current_uniform_){
+        misses_++;
+        return true;
+    }
+
+    UniformCache &cache = *current_uniform_;
+    if (location >= (GLint) cache.size()){
+        UniformValue unset;
+        unset.set = false;
+        cache.resize(location + 1, unset);
+    }
+
+    UniformValue &cached = cache[location];
+    if (cached.set && (memcmp(cached.value, value, count*sizeof(GLfloat)) == 0)){
+        hits_++;
+        return false;
+    }
+    cached.set = true;
+    memcpy(cached.value, value, count*sizeof(GLfloat));
+    misses_++;
+    return true;
+}
+
+} // namespace game
@@ -0,0 +1,87 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#include <map>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace game {
+
+    // Shadow copy of the OpenGL state set while drawing
+    // Calls that would not change the state are dropped before they
+    // reach the driver
+    // Bindings are only valid as long as all changes go through this
+    // class; call Invalidate() after other code binds objects
+    class GLState {
+
+        public:
+            GLState(void);
+            ~GLState();
+
+            // Forget the bindings, so that the next calls are issued
+            // Uniform values are kept, since they are stored in the
+            // programs themselves
+            void Invalidate(void);
+
+            // Bindings
+            void UseProgram(GLuint program);
+            void BindVertexArray(GLuint vertex_array);
+            // Only GL_ARRAY_BUFFER and GL_UNIFORM_BUFFER are tracked,
+            // since the element buffer belongs to the vertex array
+            void BindBuffer(GLenum target, GLuint buffer);
+            void ActiveTexture(GLenum unit);
+            void BindTexture(GLenum target, GLuint texture);
+
+            // Uniforms of the program in use
+            void Uniform1i(GLint location, GLint value);
+            void Uniform1f(GLint location, GLfloat value);
+            void UniformMatrix4fv(GLint location, const GLfloat *value);
+
+            // Calls dropped and issued since the counters were reset
+            int GetHits(void) const;
+            int GetMisses(void) const;
+            // Issued calls of each kind since the counters were reset
+            int GetProgramChanges(void) const;
+            int GetTextureBinds(void) const;
+            int GetUniformUploads(void) const;
+            void ResetCounters(void);
+
+        private:
+            // Number of texture units tracked
+            static const int num_texture_units_ = 16;
+            // Value of a binding that is not known
+            static const GLuint unknown_ = 0xFFFFFFFF;
+
+            // Last value set on a uniform location
+            struct UniformValue {
+                bool set;
+                GLfloat value[16];
+            };
+            typedef std::vector<UniformValue> UniformCache;
+
+            GLuint program_; // Current bindings, or unknown_
+            GLuint vertex_array_;
+            GLuint array_buffer_;
+            GLuint uniform_buffer_;
+            GLuint active_texture_;
+            GLuint texture_[num_texture_units_]; // 2D texture of each unit
+            std::map<GLuint, UniformCache> uniform_; // Uniform values of each program
+            UniformCache *current_uniform_; // Uniform values of the program in use
+            int hits_;
+            int misses_;
+            int program_changes_;
+            int texture_binds_;
+            int uniform_uploads_;
+
+            // Check a binding against its cached value, and update it
+            bool Changed(GLuint &cached, GLuint value);
+            // Check a uniform value against its cached value, and update it
+            bool Changed(GLint location, const GLfloat *value, int count);
+
+    }; // class GLState
+
+} // namespace game
+
+#endif // GL_STATE_H_
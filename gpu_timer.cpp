@@ -0,0 +1,189 @@
+#include <cstring>
+
+#include "gpu_timer.h"
+#include "profiler.h"
+
+namespace game {
+
+GpuTimer::GpuTimer(void){
+
+    for (int i = 0; i < num_frames_; i++){
+        frame_[i].used = 0;
+        frame_[i].pending = false;
+        frame_[i].number = 0;
+        frame_[i].cpu_time = 0;
+        frame_[i].gpu_time = 0;
+    }
+    current_ = -1;
+    next_ = 0;
+    frame_number_ = 0;
+    frame_time_ = 0.0;
+    result_number_ = 0;
+}
+
+
+GpuTimer::~GpuTimer(){
+
+    // Queries created by Timestamp() in each frame slot
+    for (int i = 0; i < num_frames_; i++){
+        if (frame_[i].query.size() > 0){
+            glDeleteQueries(frame_[i].query.size(), &frame_[i].query[0]);
+        }
+    }
+}
+
+
+bool GpuTimer::IsSupported(void) const {
+
+    return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+}
+
+
+void GpuTimer::BeginFrame(void){
+
+    current_ = -1;
+    if (!IsSupported()){
+        return;
+    }
+    frame_number_++;
+
+    // Read the frames that the GPU has finished, oldest first
+    // Frames complete in order, so stop at the first one still running
+    for (int i = 0; i < num_frames_; i++){
+        Frame &frame = frame_[(next_ + i) % num_frames_];
+        if (!frame.pending){
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(frame.query[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available){
+            break;
+        }
+        Read(frame);
+    }
+
+    // Skip this frame rather than wait for the oldest one
+    Frame &frame = frame_[next_];
+    if (frame.pending){
+        return;
+    }
+    current_ = next_;
+    next_ = (next_ + 1) % num_frames_;
+    frame.used = 0;
+    frame.number = frame_number_;
+
+    // Match the two clocks, to place the results on the profiler trace
+#ifdef ENABLE_PROFILER
+    frame.cpu_time = Profiler::Now();
+    glGetInteger64v(GL_TIMESTAMP, &frame.gpu_time);
+#endif
+    Timestamp(NULL);
+}
+
+
+void GpuTimer::Mark(const char *label){
+
+    Timestamp(label);
+}
+
+
+void GpuTimer::EndFrame(void){
+
+    if (current_ < 0){
+        return;
+    }
+    Frame &frame = frame_[current_];
+    frame.pending = (frame.used > 1);
+    current_ = -1;
+}
+
+
+const std::vector<GpuTimer::Interval> &GpuTimer::GetIntervals(void) const {
+
+    return interval_;
+}
+
+
+double GpuTimer::GetFrameTime(void) const {
+
+    return frame_time_;
+}
+
+
+int GpuTimer::GetLatency(void) const {
+
+    return frame_number_ - result_number_;
+}
+
+
+void GpuTimer::Report(std::ostream &out) const {
+
+    out << "GPU " << frame_time_ << " ms (" << GetLatency() << " frames ago):";
+    for (int i = 0; i < interval_.size(); i++){
+        out << (i > 0 ? ", " : " ") << interval_[i].label << " " << interval_[i].time;
+    }
+    out << std::endl;
+}
+
+
+void GpuTimer::Timestamp(const char *label){
+
+    if (current_ < 0){
+        return;
+    }
+
+    // Queries are created as needed, and reused by later frames
+    Frame &frame = frame_[current_];
+    if (frame.used == frame.query.size()){
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.query.push_back(query);
+        frame.label.push_back(NULL);
+    }
+    glQueryCounter(frame.query[frame.used], GL_TIMESTAMP);
+    frame.label[frame.used] = label;
+    frame.used++;
+}
+
+
+void GpuTimer::Read(Frame &frame){
+
+    std::vector<GLuint64> time(frame.used);
+    for (int i = 0; i < frame.used; i++){
+        glGetQueryObjectui64v(frame.query[i], GL_QUERY_RESULT, &time[i]);
+    }
+
+    // Sum the intervals of each label, in nanoseconds
+    interval_.clear();
+    for (int i = 1; i < frame.used; i++){
+        double elapsed = (double) (time[i] - time[i - 1]);
+        int j = 0;
+        while ((j < interval_.size()) && (strcmp(interval_[j].label, frame.label[i]) != 0)){
+            j++;
+        }
+        if (j == interval_.size()){
+            Interval interval;
+            interval.label = frame.label[i];
+            interval.time = 0.0;
+            interval_.push_back(interval);
+        }
+        interval_[j].time += elapsed;
+    }
+    for (int j = 0; j < interval_.size(); j++){
+        interval_[j].time /= 1000000.0;
+    }
+    frame_time_ = (time[frame.used - 1] - time[0]) / 1000000.0;
+    result_number_ = frame.number;
+    frame.pending = false;
+
+    // Add the frame and its intervals to the GPU track of the trace
+#ifdef ENABLE_PROFILER
+    int64_t offset = frame.cpu_time - frame.gpu_time;
+    Profiler::RecordGpu("GPU frame", time[0] + offset, time[frame.used - 1] + offset);
+    for (int i = 1; i < frame.used; i++){
+        Profiler::RecordGpu(frame.label[i], time[i - 1] + offset, time[i] + offset);
+    }
+#endif
+}
+
+} // namespace game
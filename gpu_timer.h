@@ -0,0 +1,85 @@
+#ifndef GPU_TIMER_H_
+#define GPU_TIMER_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // GPU time of the parts of a frame, measured with timestamp queries
+    // A frame is cut into consecutive intervals by marks, each charged
+    // to a label (e.g., the clear, or one material)
+    // Results are read a few frames later, once the GPU has reached them,
+    // so timing never waits for the GPU; if it falls too far behind,
+    // frames are not timed until it catches up
+    class GpuTimer {
+
+        public:
+            // GPU time charged to one label in a frame, in milliseconds
+            struct Interval {
+                const char *label;
+                double time;
+            };
+
+            GpuTimer(void);
+            ~GpuTimer();
+
+            // Whether timestamp queries are available (OpenGL 3.3)
+            bool IsSupported(void) const;
+
+            // Collect the results that arrived, and start timing a frame
+            void BeginFrame(void);
+            // End the current interval, and charge it to a label
+            // Labels must stay valid, e.g., string literals or names of
+            // materials
+            void Mark(const char *label);
+            // Finish timing the frame
+            void EndFrame(void);
+
+            // Intervals of the latest frame with results, summed by label
+            // in the order they first appear
+            const std::vector<Interval> &GetIntervals(void) const;
+            // GPU time from the first to the last mark of that frame
+            double GetFrameTime(void) const;
+            // Number of frames between that frame and the current one
+            int GetLatency(void) const;
+            // Print the intervals on one line
+            void Report(std::ostream &out) const;
+
+        private:
+            // Number of frames in flight before timing is skipped
+            static const int num_frames_ = 4;
+
+            // Queries of one frame: a timestamp at the start, then one
+            // for each mark
+            struct Frame {
+                std::vector<GLuint> query;
+                std::vector<const char *> label; // Label of each query, from the second
+                int used; // Number of queries issued
+                bool pending; // Issued, and results not read yet
+                int number; // Frame counter when timed
+                int64_t cpu_time; // Profiler clock at the start of the frame
+                GLint64 gpu_time; // GPU clock at the same moment
+            };
+
+            Frame frame_[num_frames_];
+            int current_; // Frame being timed, or -1 when skipped
+            int next_; // Slot for the next frame
+            int frame_number_; // Number of frames begun
+            std::vector<Interval> interval_; // Results of the latest frame read
+            double frame_time_;
+            int result_number_; // Frame counter of the results
+
+            // Issue a timestamp query in the current frame
+            void Timestamp(const char *label);
+            // Read the results of a frame whose queries have all completed
+            void Read(Frame &frame);
+
+    }; // class GpuTimer
+
+} // namespace game
+
+#endif // GPU_TIMER_H_
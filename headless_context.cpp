@@ -0,0 +1,164 @@
+#include <cstring>
+#include <string>
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "headless_context.h"
+#include "game.h"
+
+namespace game {
+
+HeadlessContext::HeadlessContext(void){
+
+    display_ = NULL;
+    surface_ = NULL;
+    context_ = NULL;
+    framebuffer_ = 0;
+    color_buffer_ = 0;
+    depth_buffer_ = 0;
+    width_ = 0;
+    height_ = 0;
+}
+
+
+HeadlessContext::~HeadlessContext(){
+
+#ifdef HAVE_EGL
+    if (!display_){
+        return;
+    }
+
+    // Framebuffer objects belong to the context, so delete them first
+    if (framebuffer_){
+        glDeleteFramebuffers(1, &framebuffer_);
+        glDeleteRenderbuffers(1, &color_buffer_);
+        glDeleteRenderbuffers(1, &depth_buffer_);
+    }
+
+    EGLDisplay display = (EGLDisplay) display_;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context_){
+        eglDestroyContext(display, (EGLContext) context_);
+    }
+    if (surface_){
+        eglDestroySurface(display, (EGLSurface) surface_);
+    }
+    eglTerminate(display);
+#endif
+}
+
+
+void HeadlessContext::Init(void){
+
+#ifdef HAVE_EGL
+    // The surfaceless platform of Mesa needs neither a display server
+    // nor a GPU
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (client_extensions && strstr(client_extensions, "EGL_MESA_platform_surfaceless") && get_platform_display){
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (display == EGL_NO_DISPLAY){
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if ((display == EGL_NO_DISPLAY) || !eglInitialize(display, NULL, NULL)){
+        throw(GameException(std::string("Could not initialize an EGL display")));
+    }
+    display_ = display;
+
+    // Same kind of context as a GLFW window: desktop OpenGL, default version
+    if (!eglBindAPI(EGL_OPENGL_API)){
+        throw(GameException(std::string("EGL display does not support desktop OpenGL")));
+    }
+    const EGLint config_attrib[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_config = 0;
+    if (!eglChooseConfig(display, config_attrib, &config, 1, &num_config) || (num_config < 1)){
+        throw(GameException(std::string("Could not find an EGL configuration for OpenGL")));
+    }
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT){
+        throw(GameException(std::string("Could not create an EGL context")));
+    }
+    context_ = context;
+
+    // Frames go to a framebuffer object, so a surface is only needed to
+    // make the context current where surfaceless contexts are missing
+    EGLSurface surface = EGL_NO_SURFACE;
+    const char *display_extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!display_extensions || !strstr(display_extensions, "EGL_KHR_surfaceless_context")){
+        const EGLint surface_attrib[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surface_attrib);
+        if (surface == EGL_NO_SURFACE){
+            throw(GameException(std::string("Could not create an EGL pbuffer")));
+        }
+        surface_ = surface;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)){
+        throw(GameException(std::string("Could not make the EGL context current")));
+    }
+#else
+    throw(GameException(std::string("Headless mode needs a build with EGL")));
+#endif
+}
+
+
+void HeadlessContext::InitFramebuffer(int width, int height){
+
+    width_ = width;
+    height_ = height;
+
+    glGenRenderbuffers(1, &color_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &depth_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Stays bound for the whole run, in place of the default framebuffer
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        throw(GameException(std::string("Offscreen framebuffer is incomplete")));
+    }
+}
+
+
+bool HeadlessContext::IsActive(void) const {
+
+    return context_ != NULL;
+}
+
+
+int HeadlessContext::GetWidth(void) const {
+
+    return width_;
+}
+
+
+int HeadlessContext::GetHeight(void) const {
+
+    return height_;
+}
+
+
+void HeadlessContext::Present(void){
+
+    glFinish();
+}
+
+} // namespace game
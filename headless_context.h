@@ -0,0 +1,53 @@
+#ifndef HEADLESS_CONTEXT_H_
+#define HEADLESS_CONTEXT_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // OpenGL context without any window, for machines with no display
+    // The context is created with EGL, on the Mesa surfaceless platform
+    // when available (e.g., llvmpipe), or else on the default display
+    // with a small pbuffer; frames are drawn into a framebuffer object
+    // of the requested size
+    class HeadlessContext {
+
+        public:
+            HeadlessContext(void);
+            ~HeadlessContext();
+
+            // Create the context and make it current
+            void Init(void);
+            // Create and bind the framebuffer that frames are drawn into
+            // Call once OpenGL functions are loaded
+            void InitFramebuffer(int width, int height);
+
+            // Whether Init() was called successfully
+            bool IsActive(void) const;
+            // Size of the framebuffer
+            int GetWidth(void) const;
+            int GetHeight(void) const;
+
+            // End a frame, in place of swapping buffers: wait until it is
+            // completely drawn, so that frame times include the GPU work
+            void Present(void);
+
+        private:
+            // EGL objects, kept opaque so that EGL is only needed where
+            // this class is implemented
+            void *display_;
+            void *surface_; // Pbuffer, when surfaceless contexts are not supported
+            void *context_;
+
+            GLuint framebuffer_;
+            GLuint color_buffer_;
+            GLuint depth_buffer_;
+            int width_;
+            int height_;
+
+    }; // class HeadlessContext
+
+} // namespace game
+
+#endif // HEADLESS_CONTEXT_H_
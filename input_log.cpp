@@ -0,0 +1,166 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "input_log.h"
+
+namespace game {
+
+// Start of every file, followed by the format version
+const char input_log_magic_g[4] = { 'G', 'I', 'N', 'P' };
+const uint32_t input_log_version_g = 1;
+
+
+InputLog::InputLog(void){
+
+    memset(&header_, 0, sizeof(header_));
+    next_ = 0;
+    end_tick_ = 0;
+}
+
+
+InputLog::~InputLog(){
+}
+
+
+void InputLog::Create(const std::string &filename, const Header &header){
+
+    file_.open(filename.c_str(), std::ios::binary);
+    if (file_.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+filename));
+    }
+    header_ = header;
+
+    // The time step is stored as the bits of the double
+    uint64_t time_step;
+    memcpy(&time_step, &header.time_step, sizeof(time_step));
+    file_.write(input_log_magic_g, sizeof(input_log_magic_g));
+    WriteBytes(input_log_version_g, 4);
+    WriteBytes(header.seed, 4);
+    WriteBytes(time_step, 8);
+    WriteBytes((uint32_t) header.stress_nodes, 4);
+    WriteBytes((uint32_t) header.stress_depth, 4);
+    file_.flush();
+}
+
+
+void InputLog::Write(uint32_t tick, int key, int action){
+
+    // Keys fit in 16 bits (GLFW_KEY_UNKNOWN is -1), actions in 8
+    WriteBytes(tick, 4);
+    WriteBytes((uint16_t) key, 2);
+    WriteBytes((uint8_t) action, 1);
+
+    // Key events are rare, so each one goes to the file right away and
+    // a crash loses none of them
+    file_.flush();
+    if (file_.fail()){
+        throw(std::ios_base::failure(std::string("Error writing input log")));
+    }
+}
+
+
+void InputLog::Close(uint32_t tick){
+
+    if (!file_.is_open()){
+        return;
+    }
+    WriteBytes(tick, 4);
+    WriteBytes(0, 2);
+    WriteBytes(end_mark_, 1);
+    file_.close();
+}
+
+
+bool InputLog::IsRecording(void) const {
+
+    return file_.is_open();
+}
+
+
+void InputLog::Load(const std::string &filename){
+
+    std::ifstream f;
+    f.open(filename.c_str(), std::ios::binary);
+    if (f.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+filename));
+    }
+
+    char magic[sizeof(input_log_magic_g)];
+    f.read(magic, sizeof(magic));
+    if (f.fail() || (memcmp(magic, input_log_magic_g, sizeof(magic)) != 0) || (ReadBytes(f, 4) != input_log_version_g)){
+        throw(std::runtime_error(std::string("Not an input recording: ")+filename));
+    }
+    header_.seed = ReadBytes(f, 4);
+    uint64_t time_step = ReadBytes(f, 8);
+    memcpy(&header_.time_step, &time_step, sizeof(time_step));
+    header_.stress_nodes = (int32_t) ReadBytes(f, 4);
+    header_.stress_depth = (int32_t) ReadBytes(f, 4);
+    if (f.fail()){
+        throw(std::runtime_error(std::string("Truncated input recording: ")+filename));
+    }
+
+    // Events up to the end mark, or up to the end of a file cut short
+    event_.clear();
+    next_ = 0;
+    end_tick_ = 0;
+    while (true){
+        Event event;
+        event.tick = ReadBytes(f, 4);
+        event.key = (int16_t) ReadBytes(f, 2);
+        event.action = ReadBytes(f, 1);
+        if (f.fail()){
+            break;
+        }
+        end_tick_ = event.tick;
+        if (event.action == end_mark_){
+            break;
+        }
+        event_.push_back(event);
+    }
+}
+
+
+const InputLog::Header &InputLog::GetHeader(void) const {
+
+    return header_;
+}
+
+
+bool InputLog::Next(uint32_t tick, Event &event){
+
+    if ((next_ >= event_.size()) || (event_[next_].tick > tick)){
+        return false;
+    }
+    event = event_[next_++];
+    return true;
+}
+
+
+bool InputLog::IsFinished(uint32_t tick) const {
+
+    return (next_ >= event_.size()) && (tick >= end_tick_);
+}
+
+
+void InputLog::WriteBytes(uint64_t value, int num_bytes){
+
+    char bytes[8];
+    for (int i = 0; i < num_bytes; i++){
+        bytes[i] = (char) ((value >> (8*i)) & 0xFF);
+    }
+    file_.write(bytes, num_bytes);
+}
+
+
+uint64_t InputLog::ReadBytes(std::istream &in, int num_bytes){
+
+    unsigned char bytes[8] = { 0 };
+    in.read((char *) bytes, num_bytes);
+    uint64_t value = 0;
+    for (int i = 0; i < num_bytes; i++){
+        value |= ((uint64_t) bytes[i]) << (8*i);
+    }
+    return value;
+}
+
+} // namespace game
@@ -0,0 +1,74 @@
+#ifndef INPUT_LOG_H_
+#define INPUT_LOG_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace game {
+
+    // Key events of a session, stamped with the simulation step they
+    // arrived before, together with the settings the simulation depends
+    // on, so that the session can be replayed step for step
+    // Files are little-endian binary: a header, then 7 bytes per event,
+    // then an end mark holding the last step of the session
+    class InputLog {
+
+        public:
+            // Settings of the recorded session
+            struct Header {
+                uint32_t seed; // Seed of the random numbers of the game
+                double time_step; // Length of a simulation step, in seconds
+                int32_t stress_nodes; // Size of the stress scene
+                int32_t stress_depth;
+            };
+
+            // One key event, applied before step tick
+            struct Event {
+                uint32_t tick;
+                int key;
+                int action;
+            };
+
+            InputLog(void);
+            ~InputLog();
+
+            // Recording: open a file and write the header, then append
+            // events as they arrive, each flushed to the file; Close()
+            // writes the end mark
+            // A file without an end mark (e.g., after a crash) replays up
+            // to its last event
+            void Create(const std::string &filename, const Header &header);
+            void Write(uint32_t tick, int key, int action);
+            void Close(uint32_t tick);
+            bool IsRecording(void) const;
+
+            // Replay: read a whole file, then take its events in order
+            void Load(const std::string &filename);
+            const Header &GetHeader(void) const;
+            // Take the next event due before the given step, if any
+            bool Next(uint32_t tick, Event &event);
+            // Whether all events were taken and the session ended by the
+            // given step
+            bool IsFinished(uint32_t tick) const;
+
+        private:
+            // Action stored in the end mark
+            static const uint8_t end_mark_ = 0xFF;
+
+            std::ofstream file_; // File being recorded
+            Header header_;
+            std::vector<Event> event_; // Events loaded for replay
+            int next_; // Next event to replay
+            uint32_t end_tick_; // Last step of the session
+
+            // Little-endian encoding
+            void WriteBytes(uint64_t value, int num_bytes);
+            static uint64_t ReadBytes(std::istream &in, int num_bytes);
+
+    }; // class InputLog
+
+} // namespace game
+
+#endif // INPUT_LOG_H_
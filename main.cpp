@@ -1,23 +1,89 @@
 #include <iostream>
 #include <exception>
+#include <cstdlib>
+#include <cstring>
 #include "game.h"
+#include "profiler.h"
 
 // Macro for printing exceptions
 #define PrintException(exception_object)\
 	std::cerr << exception_object.what() << std::endl
 
+// Simulated time of a frame during a replay, so that replays draw the
+// same frames on every machine
+const double replay_frame_time_g = 1.0/60.0;
+
 // Main function that builds and runs the game
-int main(void){
+// Options: --headless to draw offscreen without a window, --frames N
+// to stop after N frames, --trace FILE to write the timing zones of
+// the run when it ends, --stress N with --depth D to add a field of
+// N asteroids in chains of depth D, --record FILE to record the keys of
+// the session, --replay FILE to play a recording back headless, and
+// --pacing vsync|adaptive|capped|uncapped with --rate HZ for the capped
+// mode
+int main(int argc, char *argv[]){
     game::Game app; // Game application
+    bool headless = false;
+    int frames = 0;
+    std::string trace;
+    int stress_nodes = 0;
+    int stress_depth = 1;
+    std::string record;
+    std::string replay;
+    std::string pacing;
+    double rate = 60.0;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--headless") == 0){
+            headless = true;
+        } else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc)){
+            frames = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc)){
+            trace = argv[++i];
+        } else if ((strcmp(argv[i], "--stress") == 0) && (i + 1 < argc)){
+            stress_nodes = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--depth") == 0) && (i + 1 < argc)){
+            stress_depth = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--record") == 0) && (i + 1 < argc)){
+            record = argv[++i];
+        } else if ((strcmp(argv[i], "--replay") == 0) && (i + 1 < argc)){
+            replay = argv[++i];
+            headless = true;
+        } else if ((strcmp(argv[i], "--pacing") == 0) && (i + 1 < argc)){
+            pacing = argv[++i];
+        } else if ((strcmp(argv[i], "--rate") == 0) && (i + 1 < argc)){
+            rate = atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--headless] [--frames N] [--trace FILE] [--stress N] [--depth D] [--record FILE | --replay FILE]"
+                      << " [--pacing vsync|adaptive|capped|uncapped] [--rate HZ]" << std::endl;
+            return 1;
+        }
+    }
+
+    game::Profiler::SetThreadName("Main");
 
     try {
         // Initialize game
-        app.Init();
+        app.Init(headless);
+        app.SetFrameLimit(frames);
+        if (!pacing.empty()){
+            app.SetPacing(game::FramePacer::GetModeFromName(pacing), rate);
+        }
+        app.SetStressScene(stress_nodes, stress_depth);
+        if (!replay.empty()){
+            app.StartReplay(replay);
+            app.SetFixedFrameTime(replay_frame_time_g);
+        } else if (!record.empty()){
+            app.StartRecording(record);
+        }
         // Setup the main resources and scene in the game
         app.SetupResources();
         app.SetupScene();
         // Run game
         app.MainLoop();
+        if (!trace.empty()){
+            game::Profiler::WriteTrace(trace);
+        }
     }
     catch (std::exception &e){
         PrintException(e);
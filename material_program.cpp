@@ -0,0 +1,199 @@
+#include <stdexcept>
+
+#include "material_program.h"
+
+namespace game {
+
+// Names of the known attributes and uniforms, in slot order
+static const char *attribute_name_g[NumAttributeSlots] = { "vertex", "normal", "color", "uv", "instance_world_mat", "instance_normal_mat" };
+// Fixed locations of the attributes; matrices take four locations each
+static const GLuint attribute_location_g[NumAttributeSlots] = { 0, 1, 2, 3, 4, 8 };
+static const char *uniform_name_g[NumUniformSlots] = { "world_mat", "normal_mat", "view_mat", "projection_mat", "timer", "texture_map" };
+
+
+MaterialProgram::MaterialProgram(GLuint program, GLuint instanced_program){
+
+    program_ = program;
+
+    Reflect();
+
+    // Keep the instanced variant only if it really reads its world
+    // transformation from the instance attributes
+    instanced_ = NULL;
+    if (instanced_program > 0){
+        instanced_ = new MaterialProgram(instanced_program);
+        if (instanced_->GetAttribute(InstanceWorldAttribute) < 0){
+            delete instanced_;
+            instanced_ = NULL;
+            glDeleteProgram(instanced_program);
+        }
+    }
+}
+
+
+MaterialProgram::~MaterialProgram(){
+
+    delete instanced_;
+}
+
+
+GLuint MaterialProgram::GetProgram(void) const {
+
+    return program_;
+}
+
+
+void MaterialProgram::SetName(const std::string name){
+
+    name_ = name;
+    if (instanced_){
+        instanced_->SetName(name + " (instanced)");
+    }
+}
+
+
+const std::string &MaterialProgram::GetName(void) const {
+
+    return name_;
+}
+
+
+const MaterialProgram *MaterialProgram::GetInstanced(void) const {
+
+    return instanced_;
+}
+
+
+GLint MaterialProgram::GetAttribute(AttributeSlot slot) const {
+
+    return attribute_slot_[slot];
+}
+
+
+GLint MaterialProgram::GetUniform(UniformSlot slot) const {
+
+    return uniform_slot_[slot];
+}
+
+
+GLuint MaterialProgram::GetLayout(void) const {
+
+    return layout_;
+}
+
+
+GLint MaterialProgram::GetAttributeLocation(const std::string name) const {
+
+    return FindLocation(attributes_, name);
+}
+
+
+GLint MaterialProgram::GetUniformLocation(const std::string name) const {
+
+    return FindLocation(uniforms_, name);
+}
+
+
+void MaterialProgram::BindAttributeLocations(GLuint program){
+
+    for (int i = 0; i < NumAttributeSlots; i++){
+        glBindAttribLocation(program, attribute_location_g[i], attribute_name_g[i]);
+    }
+}
+
+
+bool MaterialProgram::UsesFrameBlock(void) const {
+
+    return frame_block_;
+}
+
+
+int MaterialProgram::GetNumAttributes(void) const {
+
+    return attributes_.size();
+}
+
+
+int MaterialProgram::GetNumUniforms(void) const {
+
+    return uniforms_.size();
+}
+
+
+void MaterialProgram::Reflect(void){
+
+    // Longest name we may need to read back
+    GLint max_length, attrib_length, uniform_length;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attrib_length);
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniform_length);
+    max_length = (attrib_length > uniform_length) ? attrib_length : uniform_length;
+    std::vector<GLchar> buffer(max_length + 1);
+
+    // Active attributes
+    GLint num_attributes;
+    glGetProgramiv(program_, GL_ACTIVE_ATTRIBUTES, &num_attributes);
+    for (int i = 0; i < num_attributes; i++){
+        ActiveVariable var;
+        GLsizei length;
+        glGetActiveAttrib(program_, i, buffer.size(), &length, &var.size, &var.type, &buffer[0]);
+        var.name = std::string(&buffer[0], length);
+        var.location = glGetAttribLocation(program_, var.name.c_str());
+        attributes_.push_back(var);
+    }
+
+    // Active uniforms
+    // Arrays are reported as "name[0]", so keep only the base name
+    GLint num_uniforms;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    for (int i = 0; i < num_uniforms; i++){
+        ActiveVariable var;
+        GLsizei length;
+        glGetActiveUniform(program_, i, buffer.size(), &length, &var.size, &var.type, &buffer[0]);
+        var.name = std::string(&buffer[0], length);
+        var.location = glGetUniformLocation(program_, var.name.c_str());
+        std::string::size_type bracket = var.name.find('[');
+        if (bracket != std::string::npos){
+            var.name = var.name.substr(0, bracket);
+        }
+        uniforms_.push_back(var);
+    }
+
+    // Resolve the variables used by the engine to fixed slots
+    for (int i = 0; i < NumAttributeSlots; i++){
+        attribute_slot_[i] = FindLocation(attributes_, attribute_name_g[i]);
+    }
+    for (int i = 0; i < NumUniformSlots; i++){
+        uniform_slot_[i] = FindLocation(uniforms_, uniform_name_g[i]);
+    }
+
+    // Attach the per-frame uniform block to its binding point, so that
+    // one buffer feeds every material
+    frame_block_ = false;
+    if (GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object){
+        GLuint block = glGetUniformBlockIndex(program_, "FrameBlock");
+        if (block != GL_INVALID_INDEX){
+            glUniformBlockBinding(program_, block, frame_block_binding_g);
+            frame_block_ = true;
+        }
+    }
+
+    // Pack the attribute locations into a layout key, five bits per slot
+    // (unused attributes are stored as 0)
+    layout_ = 0;
+    for (int i = 0; i < NumAttributeSlots; i++){
+        layout_ |= ((GLuint) (attribute_slot_[i] + 1) & 0x1F) << (5*i);
+    }
+}
+
+
+GLint MaterialProgram::FindLocation(const std::vector<ActiveVariable> &list, const std::string name){
+
+    for (int i = 0; i < list.size(); i++){
+        if (list[i].name == name){
+            return list[i].location;
+        }
+    }
+    return -1;
+}
+
+} // namespace game
@@ -0,0 +1,104 @@
+#ifndef MATERIAL_PROGRAM_H_
+#define MATERIAL_PROGRAM_H_
+
+#include <string>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace game {
+
+    // Vertex attributes of the interleaved 11-float vertex format,
+    // followed by the per-instance matrices of instanced materials
+    typedef enum AttributeSlotType { VertexAttribute, NormalAttribute, ColorAttribute, UvAttribute, InstanceWorldAttribute, InstanceNormalAttribute, NumAttributeSlots } AttributeSlot;
+
+    // Number of attributes in the interleaved vertex format
+    const int num_vertex_attributes_g = 4;
+
+    // Uniforms that the engine sets on every material
+    typedef enum UniformSlotType { WorldMatUniform, NormalMatUniform, ViewMatUniform, ProjectionMatUniform, TimerUniform, TextureMapUniform, NumUniformSlots } UniformSlot;
+
+    // Binding point of the per-frame uniform block (FrameBlock)
+    const GLuint frame_block_binding_g = 0;
+
+    // Linked shader program together with its reflected interface
+    // The active attributes and uniforms are queried once when the
+    // program is created, so drawing never looks up a name again
+    class MaterialProgram {
+
+        public:
+            // Reflect the active attributes and uniforms of a linked program
+            // 'instanced_program' is an optional variant of the same
+            // material that reads its transformations from per-instance
+            // attributes; the material takes ownership of it
+            MaterialProgram(GLuint program, GLuint instanced_program = 0);
+            ~MaterialProgram();
+
+            // OpenGL handle of the program
+            GLuint GetProgram(void) const;
+
+            // Name of the material, used in statistics
+            // The instanced variant is named after the material
+            void SetName(const std::string name);
+            const std::string &GetName(void) const;
+
+            // Instanced variant of the material, or NULL if there is none
+            const MaterialProgram *GetInstanced(void) const;
+
+            // Location of a known attribute/uniform, or -1 if the program
+            // does not use it
+            GLint GetAttribute(AttributeSlot slot) const;
+            GLint GetUniform(UniformSlot slot) const;
+
+            // Key identifying the attribute locations of the program
+            // Programs with the same key can share a vertex array object
+            GLuint GetLayout(void) const;
+
+            // Location of any other active variable, or -1 if not found
+            // Only meant for setup code, since it compares names
+            GLint GetAttributeLocation(const std::string name) const;
+            GLint GetUniformLocation(const std::string name) const;
+
+            // Bind the known attributes to fixed locations, so that all
+            // materials share one vertex layout
+            // Must be called before the program is linked
+            static void BindAttributeLocations(GLuint program);
+
+            // Whether the program reads the camera and time from the
+            // per-frame uniform block instead of plain uniforms
+            bool UsesFrameBlock(void) const;
+
+            // Number of active variables found in the program
+            int GetNumAttributes(void) const;
+            int GetNumUniforms(void) const;
+
+        private:
+            // One active variable of the program
+            struct ActiveVariable {
+                std::string name;
+                GLint location;
+                GLenum type;
+                GLint size;
+            };
+
+            GLuint program_; // Shader program
+            std::string name_; // Name of the material
+            std::vector<ActiveVariable> attributes_; // Active attributes
+            std::vector<ActiveVariable> uniforms_; // Active uniforms
+            GLint attribute_slot_[NumAttributeSlots]; // Resolved locations
+            GLint uniform_slot_[NumUniformSlots];
+            GLuint layout_; // Key built from the attribute locations
+            bool frame_block_; // Program uses the per-frame uniform block
+            MaterialProgram *instanced_; // Instanced variant of the material
+
+            // Query the program for its active variables
+            void Reflect(void);
+            // Find a variable by name in a reflected list
+            static GLint FindLocation(const std::vector<ActiveVariable> &list, const std::string name);
+
+    }; // class MaterialProgram
+
+} // namespace game
+
+#endif // MATERIAL_PROGRAM_H_
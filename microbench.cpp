@@ -0,0 +1,325 @@
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "headless_context.h"
+#include "transform_kernel.h"
+#include "build/path_config.h"
+
+// Macro for printing exceptions
+#define PrintException(exception_object)\
+	std::cerr << exception_object.what() << std::endl
+
+// Measurement settings
+const int repetitions_g = 9; // Repetitions of each case; the median is kept
+const double min_repetition_time_g = 0.01; // Seconds, at least, per repetition
+const unsigned int seed_g = 1; // Seed of the random test data
+
+// Sizes of the cases
+const int mesh_samples_g[] = { 16, 64, 256 };
+const int obstacle_count_g[] = { 1000, 100000 };
+const int scene_size_g[] = { 1000, 10000 };
+const int lookup_size_g = 10000;
+const int lookups_per_call_g = 100;
+
+// Keeps results alive, so that the compiler cannot drop the work
+volatile long sink_g;
+
+
+// Timing of one case, in nanoseconds per operation
+struct Result {
+    std::string name;
+    double median;
+    double min;
+    long calls; // Calls per repetition
+};
+
+
+// Time a function that does a number of operations per call
+// The number of calls per repetition doubles until a repetition lasts
+// long enough to be timed precisely, then the repetitions are timed
+template <class Function>
+Result Measure(const std::string &name, int ops_per_call, Function function){
+
+    Result result;
+    result.name = name;
+    result.calls = 1;
+    std::vector<double> time;
+    while (true){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < result.calls; i++){
+            function();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= min_repetition_time_g){
+            break;
+        }
+        result.calls *= 2;
+    }
+
+    for (int r = 0; r < repetitions_g; r++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < result.calls; i++){
+            function();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        time.push_back(elapsed / (result.calls*ops_per_call));
+    }
+    std::sort(time.begin(), time.end());
+    result.median = time[time.size()/2];
+    result.min = time.front();
+
+    std::cout << name << ": " << result.median << " ns/op (min " << result.min << ", "
+              << result.calls*ops_per_call << " ops per repetition)" << std::endl;
+    return result;
+}
+
+
+// Name with a size, e.g., "CreateSphere/64"
+std::string CaseName(const std::string &name, int size){
+
+    std::ostringstream ss;
+    ss << name << "/" << size;
+    return ss.str();
+}
+
+
+// Mesh generation, including the upload to the geometry arena
+// Each mesh is removed after its call, so that the next one reuses its
+// space and the arena does not grow during the measurement
+void MeasureMeshes(std::vector<Result> &results){
+
+    game::ResourceManager resman;
+    for (int i = 0; i < sizeof(mesh_samples_g)/sizeof(int); i++){
+        int samples = mesh_samples_g[i];
+        results.push_back(Measure(CaseName("CreateSphere", samples), 1, [&](){
+            resman.RemoveMesh(resman.CreateSphere("Sphere", 0.6, 2*samples, samples));
+        }));
+        results.push_back(Measure(CaseName("CreateTorus", samples), 1, [&](){
+            resman.RemoveMesh(resman.CreateTorus("Torus", 0.6, 0.2, 2*samples, samples));
+        }));
+        results.push_back(Measure(CaseName("CreateCylindricalGeometry", samples), 1, [&](){
+            resman.RemoveMesh(resman.CreateCylindricalGeometry("Cylinder", 0.5, 0.5, 0.5, samples/4, samples));
+        }));
+    }
+}
+
+
+// Collision test of the player against many obstacles
+void MeasureCollisions(std::vector<Result> &results){
+
+    std::mt19937 random(seed_g);
+    std::uniform_real_distribution<float> lane(-1.5, 1.5);
+    game::Player player("Player", NULL, NULL);
+    player.SetxMax(0.35);
+    player.SetxMin(-0.35);
+    player.SetyMax(0.18);
+    player.SetyMin(-0.50);
+
+    for (int i = 0; i < sizeof(obstacle_count_g)/sizeof(int); i++){
+        int count = obstacle_count_g[i];
+        std::vector<game::Obstacle *> obstacle(count);
+        for (int j = 0; j < count; j++){
+            obstacle[j] = new game::Obstacle(CaseName("Obstacle", j), NULL, NULL);
+            float x = lane(random);
+            float y = lane(random);
+            obstacle[j]->SetPosition(glm::vec3(x, y, 0.0));
+            obstacle[j]->SetxMax(0.3);
+            obstacle[j]->SetxMin(-0.3);
+            obstacle[j]->SetyMax(1.0);
+            obstacle[j]->SetyMin(-0.9);
+        }
+        results.push_back(Measure(CaseName("AABBcheck", count), count, [&](){
+            long hits = 0;
+            for (int j = 0; j < count; j++){
+                hits += game::Game::AABBcheck(&player, obstacle[j]);
+            }
+            sink_g = hits;
+        }));
+        for (int j = 0; j < count; j++){
+            delete obstacle[j];
+        }
+    }
+}
+
+
+// Update and traversal of a scene of spinning spheres, spread around the
+// camera so that part of them are culled; nothing is drawn
+void MeasureScene(std::vector<Result> &results){
+
+    game::ResourceManager resman;
+    resman.CreateSphere("SphereMesh", 0.6, 16, 8);
+    std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/shiny_blue");
+    resman.LoadResource(game::Material, "ObjectMaterial", filename.c_str());
+
+    game::Camera camera;
+    camera.SetView(glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, 1.0, 0.0));
+    camera.SetProjection(30.0, 0.01, 1000.0, 1200, 1400);
+    camera.SetupFrame(0.0);
+
+    for (int i = 0; i < sizeof(scene_size_g)/sizeof(int); i++){
+        int count = scene_size_g[i];
+        std::mt19937 random(seed_g);
+        std::uniform_real_distribution<float> coordinate(-100.0, 100.0);
+        game::SceneGraph scene;
+        game::SceneNode *root = new game::SceneNode("Root", NULL, NULL);
+        for (int j = 0; j < count; j++){
+            game::Asteroid *node = new game::Asteroid(CaseName("Node", j), resman.GetResource("SphereMesh"), resman.GetResource("ObjectMaterial"));
+            float x = coordinate(random);
+            float y = coordinate(random);
+            float z = coordinate(random);
+            node->SetPosition(glm::vec3(x, y, z));
+            node->SetAngM(6.0f*glm::normalize(glm::vec3(x, y, z)));
+            root->AddChild(node);
+        }
+        scene.SetRoot(root);
+
+        results.push_back(Measure(CaseName("SceneGraph::Update", count), count, [&](){
+            scene.Update(1.0/120.0);
+        }));
+        results.push_back(Measure(CaseName("SceneGraph::Collect", count), count, [&](){
+            scene.Collect(&camera);
+        }));
+
+        // Lookups by name, spread over the whole hierarchy
+        if (count == lookup_size_g){
+            std::vector<std::string> name(lookups_per_call_g);
+            for (int j = 0; j < lookups_per_call_g; j++){
+                name[j] = CaseName("Node", random() % count);
+            }
+            results.push_back(Measure(CaseName("SceneGraph::GetNode", count), lookups_per_call_g, [&](){
+                long found = 0;
+                for (int j = 0; j < lookups_per_call_g; j++){
+                    found += (scene.GetNode(name[j]) != NULL);
+                }
+                sink_g = found;
+            }));
+        }
+    }
+}
+
+
+// Lookup of resources by name
+void MeasureResources(std::vector<Result> &results){
+
+    // Placeholder resources: lookups only compare names
+    game::ResourceManager resman;
+    for (int i = 0; i < lookup_size_g; i++){
+        resman.AddResource(game::Texture, CaseName("Resource", i), 0, 0);
+    }
+
+    std::mt19937 random(seed_g);
+    std::vector<std::string> name(lookups_per_call_g);
+    for (int i = 0; i < lookups_per_call_g; i++){
+        name[i] = CaseName("Resource", random() % lookup_size_g);
+    }
+    results.push_back(Measure(CaseName("ResourceManager::GetResource", lookup_size_g), lookups_per_call_g, [&](){
+        long found = 0;
+        for (int i = 0; i < lookups_per_call_g; i++){
+            found += (resman.GetResource(name[i]) != NULL);
+        }
+        sink_g = found;
+    }));
+
+    // Same lookups through handles resolved beforehand
+    std::vector<game::TextureHandle> handle(lookups_per_call_g);
+    for (int i = 0; i < lookups_per_call_g; i++){
+        handle[i] = resman.GetTexture(name[i]);
+    }
+    results.push_back(Measure(CaseName("ResourceManager::GetResource(handle)", lookup_size_g), lookups_per_call_g, [&](){
+        long found = 0;
+        for (int i = 0; i < lookups_per_call_g; i++){
+            found += (resman.GetResource(handle[i]) != NULL);
+        }
+        sink_g = found;
+    }));
+}
+
+
+// Microbenchmarks of the core primitives, without a window
+// Cases that need OpenGL run on an offscreen context; without one, they
+// are skipped
+// Options: --filter TEXT to run the groups whose name contains TEXT
+// (meshes, collisions, scene, resources), and --json FILE to write the
+// results
+int main(int argc, char *argv[]){
+    std::string filter;
+    std::string json;
+
+    for (int i = 1; i < argc; i++){
+        if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)){
+            filter = argv[++i];
+        } else if ((strcmp(argv[i], "--json") == 0) && (i + 1 < argc)){
+            json = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter TEXT] [--json FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    try {
+        // OpenGL context for the cases that create meshes and materials
+        game::HeadlessContext context;
+        bool has_context = true;
+        try {
+            context.Init();
+            glewExperimental = GL_TRUE;
+            GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+            if (err == GLEW_ERROR_NO_GLX_DISPLAY){
+                err = GLEW_OK;
+            }
+#endif
+            has_context = (err == GLEW_OK);
+        }
+        catch (std::exception &e){
+            PrintException(e);
+            has_context = false;
+        }
+        if (!has_context){
+            std::cerr << "No OpenGL context: skipping meshes and scene" << std::endl;
+        }
+        std::cout << "Transform kernel: " << game::TransformKernel::GetPathName(game::TransformKernel::GetPath()) << std::endl;
+
+        if (has_context && (std::string("meshes").find(filter) != std::string::npos)){
+            MeasureMeshes(results);
+        }
+        if (std::string("collisions").find(filter) != std::string::npos){
+            MeasureCollisions(results);
+        }
+        if (has_context && (std::string("scene").find(filter) != std::string::npos)){
+            MeasureScene(results);
+        }
+        if (std::string("resources").find(filter) != std::string::npos){
+            MeasureResources(results);
+        }
+    }
+    catch (std::exception &e){
+        PrintException(e);
+        return 1;
+    }
+
+    if (!json.empty()){
+        std::ofstream file(json.c_str());
+        if (file.fail()){
+            std::cerr << "Error opening file " << json << std::endl;
+            return 1;
+        }
+        file << "{" << std::endl;
+        for (int i = 0; i < results.size(); i++){
+            file << "  \"" << results[i].name << "\": {\"median_ns\": " << results[i].median
+                 << ", \"min_ns\": " << results[i].min << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        file << "}" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "profiler.h"
+
+namespace game {
+
+thread_local Profiler::ThreadBuffer *Profiler::thread_buffer_ = NULL;
+std::mutex Profiler::mutex_;
+std::vector<Profiler::ThreadBuffer *> Profiler::buffer_;
+Profiler::ThreadBuffer *Profiler::gpu_buffer_ = NULL;
+
+// Times in traces are relative to the start of the program
+const int64_t epoch_g = Profiler::Now();
+
+
+// Copy a string into a JSON string
+static void WriteString(std::ostream &out, const char *str){
+
+    out << '"';
+    for (const char *c = str; *c; c++){
+        if ((*c == '"') || (*c == '\\')){
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+
+void Profiler::SetThreadName(const std::string &name){
+
+    ThreadBuffer *buffer = thread_buffer_;
+    if (!buffer){
+        buffer = RegisterThread();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->name = name;
+}
+
+
+void Profiler::RecordGpu(const char *name, int64_t start, int64_t end){
+
+    if (!gpu_buffer_){
+        gpu_buffer_ = CreateBuffer("GPU");
+    }
+    Write(gpu_buffer_, name, start, end);
+}
+
+
+void Profiler::WriteTrace(std::ostream &out){
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    out << "{\"traceEvents\":[" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (int i = 0; i < buffer_.size(); i++){
+        ThreadBuffer *buffer = buffer_[i];
+
+        // Name of the thread, as metadata
+        if (!first){
+            out << "," << std::endl;
+        }
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id << ",\"args\":{\"name\":";
+        WriteString(out, buffer->name.c_str());
+        out << "}}";
+
+        // Events still in the ring, oldest first, as complete events
+        // with times in microseconds
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t start = buffer->tail;
+        if (head - start > (uint64_t) buffer_size_){
+            start = head - buffer_size_;
+        }
+        for (uint64_t j = start; j < head; j++){
+            const Event &event = buffer->event[j & (buffer_size_ - 1)];
+            out << "," << std::endl << "{\"name\":";
+            WriteString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"ts\":" << (event.start - epoch_g)/1000.0
+                << ",\"dur\":" << (event.end - event.start)/1000.0 << "}";
+        }
+    }
+    out << std::endl << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+
+void Profiler::WriteTrace(const std::string &filename){
+
+    std::ofstream f;
+    f.open(filename.c_str());
+    if (f.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+filename));
+    }
+    WriteTrace(f);
+    f.close();
+}
+
+
+void Profiler::Clear(void){
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < buffer_.size(); i++){
+        buffer_[i]->tail = buffer_[i]->head.load(std::memory_order_acquire);
+    }
+}
+
+
+void Profiler::GetEvents(std::vector<Event> &events){
+
+    events.clear();
+    ThreadBuffer *buffer = thread_buffer_;
+    if (!buffer){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    uint64_t start = buffer->tail;
+    if (head - start > (uint64_t) buffer_size_){
+        start = head - buffer_size_;
+    }
+    for (uint64_t i = start; i < head; i++){
+        events.push_back(buffer->event[i & (buffer_size_ - 1)]);
+    }
+}
+
+
+Profiler::ThreadBuffer *Profiler::CreateBuffer(const std::string &name){
+
+    // Buffers are never freed, since events of a thread can be written
+    // out after it ends
+    ThreadBuffer *buffer = new ThreadBuffer;
+    buffer->head.store(0, std::memory_order_relaxed);
+    buffer->tail = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->thread_id = buffer_.size() + 1;
+    if (name.empty()){
+        std::ostringstream number;
+        number << "Thread " << buffer->thread_id;
+        buffer->name = number.str();
+    } else {
+        buffer->name = name;
+    }
+    buffer_.push_back(buffer);
+    return buffer;
+}
+
+
+Profiler::ThreadBuffer *Profiler::RegisterThread(void){
+
+    thread_buffer_ = CreateBuffer("");
+    return thread_buffer_;
+}
+
+} // namespace game
@@ -0,0 +1,132 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace game {
+
+    // Scoped CPU timing zones, recorded into a ring buffer per thread
+    // Recording takes no lock: each thread only writes to its own
+    // buffer, and the oldest events are overwritten once it is full
+    // The events can be written at any time in the trace event format
+    // of Chrome, which chrome://tracing and Perfetto can open
+    class Profiler {
+
+        public:
+            // Time of one zone on one thread, in nanoseconds
+            struct Event {
+                const char *name; // Must stay valid, e.g., a string literal
+                int64_t start;
+                int64_t end;
+            };
+
+            // Current time of the profiler clock
+            static int64_t Now(void){
+
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            // Add a zone to the buffer of the calling thread
+            static void Record(const char *name, int64_t start, int64_t end){
+
+                ThreadBuffer *buffer = thread_buffer_;
+                if (!buffer){
+                    buffer = RegisterThread();
+                }
+                Write(buffer, name, start, end);
+            }
+
+            // Add a zone to the track of the GPU, with times converted to
+            // the profiler clock
+            // Only one thread may record GPU zones
+            static void RecordGpu(const char *name, int64_t start, int64_t end);
+
+            // Name the calling thread in the trace
+            static void SetThreadName(const std::string &name);
+
+            // Write the events of all threads as a JSON trace
+            // Call it between frames: events overwritten while they are
+            // written out may be inconsistent
+            static void WriteTrace(std::ostream &out);
+            static void WriteTrace(const std::string &filename);
+            // Forget all events recorded so far
+            static void Clear(void);
+            // Events of the calling thread since the last Clear(), oldest
+            // first
+            static void GetEvents(std::vector<Event> &events);
+
+        private:
+            // Number of events kept per thread (a power of two)
+            static const int buffer_size_ = 1 << 16;
+
+            // Events of one thread, from its first zone until the end of
+            // the program, so that traces include finished threads
+            struct ThreadBuffer {
+                Event event[buffer_size_];
+                std::atomic<uint64_t> head; // Number of events ever recorded
+                uint64_t tail; // First event kept after the last Clear()
+                int thread_id;
+                std::string name;
+            };
+
+            static thread_local ThreadBuffer *thread_buffer_;
+            // Buffers of all threads that recorded a zone, guarded by a
+            // mutex that is only taken when a thread records its first
+            // zone, or when the buffers are read
+            static std::mutex mutex_;
+            static std::vector<ThreadBuffer *> buffer_;
+
+            // Track of the GPU, or NULL until a GPU zone is recorded
+            static ThreadBuffer *gpu_buffer_;
+
+            // Create a buffer, shown in traces under a name, or under its
+            // number if the name is empty
+            static ThreadBuffer *CreateBuffer(const std::string &name);
+            // Create the buffer of the calling thread
+            static ThreadBuffer *RegisterThread(void);
+
+            // Add an event to a buffer, which only one thread writes to
+            static void Write(ThreadBuffer *buffer, const char *name, int64_t start, int64_t end){
+
+                uint64_t head = buffer->head.load(std::memory_order_relaxed);
+                Event &event = buffer->event[head & (buffer_size_ - 1)];
+                event.name = name;
+                event.start = start;
+                event.end = end;
+                buffer->head.store(head + 1, std::memory_order_release);
+            }
+
+    }; // class Profiler
+
+    // Zone timed from its construction to the end of its scope
+    class ProfileZone {
+
+        public:
+            ProfileZone(const char *name) : name_(name), start_(Profiler::Now()) {}
+            ~ProfileZone() { Profiler::Record(name_, start_, Profiler::Now()); }
+
+        private:
+            const char *name_;
+            int64_t start_;
+
+    }; // class ProfileZone
+
+} // namespace game
+
+// Time the rest of the enclosing scope under a name (a string literal)
+// Zones are compiled out unless ENABLE_PROFILER is defined
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) game::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif // PROFILER_H_
@@ -0,0 +1,496 @@
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/type_ptr.hpp>
+
+#include "render_queue.h"
+
+namespace game {
+
+RenderQueue::RenderQueue(void){
+
+    instance_buffer_ = 0;
+    command_buffer_ = 0;
+    multi_draw_ = true;
+    multi_draw_calls_ = 0;
+    unsorted_state_ = EmptyState();
+    unsorted_changes_ = 0;
+    sorted_changes_ = 0;
+    draw_calls_ = 0;
+    instanced_draw_calls_ = 0;
+    instances_ = 0;
+    triangles_ = 0;
+    points_ = 0;
+    buffer_uploads_ = 0;
+}
+
+
+RenderQueue::~RenderQueue(){
+}
+
+
+void RenderQueue::Clear(void){
+
+    item_.clear();
+    key_.clear();
+    unsorted_state_ = EmptyState();
+    unsorted_changes_ = 0;
+    sorted_changes_ = 0;
+}
+
+
+void RenderQueue::Add(const DrawItem &item){
+
+    // Keep track of the state changes the traversal order would need
+    unsorted_changes_ += CountChanges(unsorted_state_, item.program, item.vertex_array, item.texture);
+
+    SortKey sk;
+    sk.key = MakeKey(item);
+    sk.index = item_.size();
+    key_.push_back(sk);
+    item_.push_back(item);
+}
+
+
+void RenderQueue::Sort(void){
+
+    // LSD radix sort on the 64-bit key, one byte per pass
+    // The sort is stable, so draws with equal keys keep traversal order
+    int n = key_.size();
+    temp_.resize(n);
+    for (int shift = 0; shift < 64; shift += 8){
+        // Histogram of the current byte
+        GLuint count[256] = { 0 };
+        for (int i = 0; i < n; i++){
+            count[(key_[i].key >> shift) & 0xFF]++;
+        }
+
+        // Skip passes where all keys have the same byte, which is the
+        // case for the unused low bits and most high bits
+        if ((n == 0) || (count[(key_[0].key >> shift) & 0xFF] == n)){
+            continue;
+        }
+
+        // Turn counts into starting positions
+        GLuint total = 0;
+        for (int b = 0; b < 256; b++){
+            GLuint c = count[b];
+            count[b] = total;
+            total += c;
+        }
+
+        // Scatter into the scratch buffer
+        for (int i = 0; i < n; i++){
+            temp_[count[(key_[i].key >> shift) & 0xFF]++] = key_[i];
+        }
+        key_.swap(temp_);
+    }
+}
+
+
+void RenderQueue::Submit(const Camera *camera, GLState *gl_state, GpuTimer *gpu_timer){
+
+    // Group the sorted draws and stream the instance data of the frame
+    // to the GPU with a single upload
+    // Building the batches may create vertex array objects, which
+    // changes bindings behind the back of the state cache
+    BuildBatches();
+    gl_state->Invalidate();
+    buffer_uploads_ = 0;
+    if (instance_data_.size() > 0){
+        if (instance_buffer_ == 0){
+            glGenBuffers(1, &instance_buffer_);
+        }
+        GLsizeiptr size = instance_data_.size()*sizeof(glm::mat4);
+        gl_state->BindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, &instance_data_[0]);
+        buffer_uploads_++;
+    }
+
+    // Same for the commands of the multi-draws, which stay bound for
+    // the whole frame
+    if (command_.size() > 0){
+        if (command_buffer_ == 0){
+            glGenBuffers(1, &command_buffer_);
+        }
+        GLsizeiptr size = command_.size()*sizeof(DrawElementsIndirectCommand);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, size, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, &command_[0]);
+        buffer_uploads_++;
+    }
+
+    if (gpu_timer){
+        gpu_timer->Mark("Upload");
+    }
+
+    BoundState state = EmptyState();
+    sorted_changes_ = 0;
+    draw_calls_ = 0;
+    instanced_draw_calls_ = 0;
+    multi_draw_calls_ = 0;
+    instances_ = 0;
+    triangles_ = 0;
+    points_ = 0;
+    const MaterialProgram *timed_program = NULL;
+    for (int b = 0; b < batch_.size(); b++){
+        const Batch &batch = batch_[b];
+        const DrawItem &first = item_[key_[batch.first].index];
+
+        const MaterialProgram *program = batch.program;
+        GLuint vertex_array = batch.vertex_array;
+
+        // Batches are sorted by program, so the draws of a material end
+        // where the program changes
+        if (gpu_timer && (program != timed_program)){
+            if (timed_program){
+                gpu_timer->Mark(timed_program->GetName().c_str());
+            }
+            timed_program = program;
+        }
+
+        // Select material (shader program)
+        // Camera and time come from the per-frame uniform block, unless
+        // the program has to get them as plain uniforms
+        // The state cache drops calls that set what is already set
+        gl_state->UseProgram(program->GetProgram());
+        if (!program->UsesFrameBlock()){
+            camera->SetupShader(program, gl_state);
+        }
+        gl_state->Uniform1i(program->GetUniform(TextureMapUniform), 0);
+
+        // Set geometry to draw
+        gl_state->BindVertexArray(vertex_array);
+
+        // Bind texture if one is set; otherwise keep the current one
+        if (first.texture > 0){
+            gl_state->ActiveTexture(GL_TEXTURE0);
+            gl_state->BindTexture(GL_TEXTURE_2D, first.texture);
+        }
+
+        sorted_changes_ += CountChanges(state, program, vertex_array, first.texture);
+
+        if (batch.num_commands > 0){
+            // One draw for this batch and the following ones that share
+            // its state; each command picks the matrices of its batch
+            // through its base instance
+            SetupInstances(program, 0, gl_state);
+            glMultiDrawElementsIndirect(first.mode, GL_UNSIGNED_INT, (const GLvoid *) (batch.first_command*sizeof(DrawElementsIndirectCommand)), batch.num_commands, 0);
+            draw_calls_++;
+            instanced_draw_calls_++;
+            multi_draw_calls_++;
+            for (int c = 0; c < batch.num_commands; c++){
+                const DrawElementsIndirectCommand &command = command_[batch.first_command + c];
+                instances_ += command.instanceCount;
+                CountPrimitives(first.mode, command.count, command.instanceCount);
+            }
+            b += batch.num_commands - 1;
+            continue;
+        }
+
+        if (batch.instanced){
+            // One draw for the whole batch, with the matrices of each
+            // instance read from the instance buffer
+            SetupInstances(program, batch.instance_offset, gl_state);
+            if (first.mode == GL_POINTS){
+                glDrawArraysInstanced(first.mode, 0, first.size, batch.count);
+            } else {
+                const GLvoid *indices = (const GLvoid *) (first.geometry->GetFirstIndex()*sizeof(GLuint));
+                GLint base_vertex = first.geometry->GetBaseVertex();
+                if (base_vertex != 0){
+                    glDrawElementsInstancedBaseVertex(first.mode, first.size, GL_UNSIGNED_INT, indices, batch.count, base_vertex);
+                } else {
+                    glDrawElementsInstanced(first.mode, first.size, GL_UNSIGNED_INT, indices, batch.count);
+                }
+            }
+            draw_calls_++;
+            instanced_draw_calls_++;
+            instances_ += batch.count;
+            CountPrimitives(first.mode, first.size, batch.count);
+            continue;
+        }
+
+        for (int i = batch.first; i < batch.first + batch.count; i++){
+            const DrawItem &item = item_[key_[i].index];
+
+            // Set world matrix and normal matrix
+            gl_state->UniformMatrix4fv(program->GetUniform(WorldMatUniform), glm::value_ptr(item.world_mat));
+            gl_state->UniformMatrix4fv(program->GetUniform(NormalMatUniform), glm::value_ptr(item.normal_mat));
+
+            // Draw geometry
+            // Meshes of the geometry arena start at their own first index,
+            // with indices relative to their base vertex
+            if (item.mode == GL_POINTS){
+                glDrawArrays(item.mode, 0, item.size);
+            } else {
+                const GLvoid *indices = (const GLvoid *) (item.geometry->GetFirstIndex()*sizeof(GLuint));
+                GLint base_vertex = item.geometry->GetBaseVertex();
+                if (base_vertex != 0){
+                    glDrawElementsBaseVertex(item.mode, item.size, GL_UNSIGNED_INT, indices, base_vertex);
+                } else {
+                    glDrawElements(item.mode, item.size, GL_UNSIGNED_INT, indices);
+                }
+            }
+            draw_calls_++;
+            CountPrimitives(item.mode, item.size, 1);
+        }
+    }
+    if (timed_program){
+        gpu_timer->Mark(timed_program->GetName().c_str());
+    }
+}
+
+
+int RenderQueue::GetSize(void) const {
+
+    return item_.size();
+}
+
+
+int RenderQueue::GetUnsortedStateChanges(void) const {
+
+    return unsorted_changes_;
+}
+
+
+int RenderQueue::GetStateChanges(void) const {
+
+    return sorted_changes_;
+}
+
+
+int RenderQueue::GetStateChangesSaved(void) const {
+
+    return unsorted_changes_ - sorted_changes_;
+}
+
+
+int RenderQueue::GetDrawCalls(void) const {
+
+    return draw_calls_;
+}
+
+
+int RenderQueue::GetInstancedDrawCalls(void) const {
+
+    return instanced_draw_calls_;
+}
+
+
+int RenderQueue::GetInstances(void) const {
+
+    return instances_;
+}
+
+
+int RenderQueue::GetMultiDrawCalls(void) const {
+
+    return multi_draw_calls_;
+}
+
+
+int RenderQueue::GetTriangles(void) const {
+
+    return triangles_;
+}
+
+
+int RenderQueue::GetPoints(void) const {
+
+    return points_;
+}
+
+
+int RenderQueue::GetBufferUploads(void) const {
+
+    return buffer_uploads_;
+}
+
+
+void RenderQueue::SetMultiDraw(bool enabled){
+
+    multi_draw_ = enabled;
+}
+
+
+bool RenderQueue::UsesMultiDraw(void) const {
+
+    // Instance attributes of a command start at its base instance,
+    // which needs base instance support too
+    return multi_draw_ && (GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance));
+}
+
+
+void RenderQueue::BuildBatches(void){
+
+    batch_.clear();
+    instance_data_.clear();
+    command_.clear();
+    bool multi_draw = UsesMultiDraw();
+
+    int n = key_.size();
+    int first = 0;
+    while (first < n){
+        // Extend the batch while the draws share the same state
+        const DrawItem &item = item_[key_[first].index];
+        int last = first + 1;
+        while ((last < n) && (key_[last].key == key_[first].key)){
+            const DrawItem &other = item_[key_[last].index];
+            if ((other.program != item.program) || (other.geometry != item.geometry) || (other.texture != item.texture)){
+                break;
+            }
+            last++;
+        }
+
+        Batch batch;
+        batch.first = first;
+        batch.count = last - first;
+        batch.program = item.program;
+        batch.vertex_array = item.vertex_array;
+        batch.instanced = false;
+        batch.instance_offset = 0;
+        batch.first_command = 0;
+        batch.num_commands = 0;
+
+        // A single draw gains nothing from instancing, unless it can be
+        // part of a multi-draw
+        bool multi_drawable = multi_draw && (item.mode != GL_POINTS);
+        if (((batch.count > 1) || multi_drawable) && item.program->GetInstanced()){
+            // Instanced batches use the instanced variant of the
+            // material, which has its own vertex array object
+            batch.program = item.program->GetInstanced();
+            batch.vertex_array = item.geometry->GetVertexArray(batch.program);
+            batch.instanced = true;
+            batch.instance_offset = instance_data_.size()*sizeof(glm::mat4);
+            for (int i = first; i < last; i++){
+                instance_data_.push_back(item_[key_[i].index].world_mat);
+                instance_data_.push_back(item_[key_[i].index].normal_mat);
+            }
+        }
+
+        batch_.push_back(batch);
+        first = last;
+    }
+
+    if (multi_draw){
+        BuildCommands();
+    }
+}
+
+
+void RenderQueue::BuildCommands(void){
+
+    // Instanced batches in a row that differ only by their geometry are
+    // drawn together, since meshes of the geometry arena share their
+    // vertex array; the first batch of a run holds its commands
+    const GLuint instance_size = 2*sizeof(glm::mat4);
+    int b = 0;
+    while (b < batch_.size()){
+        Batch &run = batch_[b];
+        const DrawItem &run_item = item_[key_[run.first].index];
+        if (!run.instanced || (run_item.mode == GL_POINTS)){
+            b++;
+            continue;
+        }
+
+        run.first_command = command_.size();
+        int last = b;
+        while (last < batch_.size()){
+            const Batch &batch = batch_[last];
+            const DrawItem &item = item_[key_[batch.first].index];
+            if (!batch.instanced || (batch.program != run.program) || (batch.vertex_array != run.vertex_array) ||
+                (item.texture != run_item.texture) || (item.mode != run_item.mode)){
+                break;
+            }
+
+            DrawElementsIndirectCommand command;
+            command.count = item.size;
+            command.instanceCount = batch.count;
+            command.firstIndex = item.geometry->GetFirstIndex();
+            command.baseVertex = item.geometry->GetBaseVertex();
+            command.baseInstance = batch.instance_offset / instance_size;
+            command_.push_back(command);
+            last++;
+        }
+        run.num_commands = last - b;
+        b = last;
+    }
+}
+
+
+void RenderQueue::SetupInstances(const MaterialProgram *program, GLsizeiptr offset, GLState *gl_state){
+
+    // Each instance stores its world matrix followed by its normal
+    // matrix; a matrix attribute takes one location per column
+    const GLsizei stride = 2*sizeof(glm::mat4);
+    gl_state->BindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+
+    GLint world_att = program->GetAttribute(InstanceWorldAttribute);
+    for (int c = 0; c < 4; c++){
+        glVertexAttribPointer(world_att + c, 4, GL_FLOAT, GL_FALSE, stride, (void *) (offset + c*sizeof(glm::vec4)));
+    }
+
+    GLint normal_att = program->GetAttribute(InstanceNormalAttribute);
+    if (normal_att >= 0){
+        for (int c = 0; c < 4; c++){
+            glVertexAttribPointer(normal_att + c, 4, GL_FLOAT, GL_FALSE, stride, (void *) (offset + sizeof(glm::mat4) + c*sizeof(glm::vec4)));
+        }
+    }
+}
+
+
+void RenderQueue::CountPrimitives(GLenum mode, GLsizei size, int instances){
+
+    // Geometry is drawn either as indexed triangles or as points
+    if (mode == GL_POINTS){
+        points_ += size*instances;
+    } else {
+        triangles_ += (size/3)*instances;
+    }
+}
+
+
+GLuint64 RenderQueue::MakeKey(const DrawItem &item){
+
+    // Most expensive state in the highest bits, then the geometry so
+    // that draws of the same mesh are next to each other for instancing
+    // Meshes of the geometry arena share their vertex array, so few bits
+    // are needed for it; truncated fields can only cost batching, since
+    // batches compare the actual state
+    GLuint64 key = 0;
+    key |= ((GLuint64) (item.program->GetProgram() & 0xFFFF)) << 48;
+    key |= ((GLuint64) (item.vertex_array & 0xFF)) << 40;
+    key |= ((GLuint64) (item.texture & 0xFFFF)) << 24;
+    key |= ((GLuint64) (item.geometry->GetFirstIndex() & 0xFFFFFF));
+    return key;
+}
+
+
+int RenderQueue::CountChanges(BoundState &state, const MaterialProgram *program, GLuint vertex_array, GLuint texture){
+
+    int changes = 0;
+    if (program != state.program){
+        state.program = program;
+        changes++;
+    }
+    if (vertex_array != state.vertex_array){
+        state.vertex_array = vertex_array;
+        changes++;
+    }
+    if ((texture > 0) && (texture != state.texture)){
+        state.texture = texture;
+        changes++;
+    }
+    return changes;
+}
+
+
+RenderQueue::BoundState RenderQueue::EmptyState(void){
+
+    BoundState state;
+    state.program = NULL;
+    state.vertex_array = 0;
+    state.texture = 0;
+    return state;
+}
+
+} // namespace game
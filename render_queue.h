@@ -0,0 +1,164 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "material_program.h"
+#include "resource.h"
+#include "camera.h"
+#include "gl_state.h"
+#include "gpu_timer.h"
+
+namespace game {
+
+    // One draw produced by traversing the scene graph
+    struct DrawItem {
+        const MaterialProgram *program; // Material (shader program)
+        const Resource *geometry; // Geometry resource
+        GLuint vertex_array; // Geometry bound with its vertex format
+        GLuint texture; // Texture, or 0 to keep the current binding
+        GLenum mode; // Type of geometry
+        GLsizei size; // Number of primitives in geometry
+        glm::mat4 world_mat; // World transformation, including scaling
+        glm::mat4 normal_mat; // Transformation for normals
+    };
+
+    // Flat list of draws, sorted by state before submission so that
+    // program, geometry and texture changes are as few as possible
+    // Draws that share program, geometry and texture are batched into a
+    // single instanced draw when the material has an instanced variant
+    // Where multi-draw indirect is available, consecutive instanced
+    // batches of different meshes that share program and texture are
+    // issued with one glMultiDrawElementsIndirect
+    class RenderQueue {
+
+        public:
+            RenderQueue(void);
+            ~RenderQueue();
+
+            // Remove all draws
+            void Clear(void);
+            // Add a draw, in traversal order
+            void Add(const DrawItem &item);
+            // Sort the draws on their state key
+            void Sort(void);
+            // Issue the draws, changing state only when needed
+            // All state changes go through the given state cache
+            // With a GPU timer, the uploads and the draws of each material
+            // are marked as separate intervals
+            void Submit(const Camera *camera, GLState *gl_state, GpuTimer *gpu_timer = NULL);
+
+            // Number of draws in the queue
+            int GetSize(void) const;
+            // State changes needed by the traversal order and by the
+            // sorted order, for the last frame
+            int GetUnsortedStateChanges(void) const;
+            int GetStateChanges(void) const;
+            // State changes removed by sorting in the last frame
+            int GetStateChangesSaved(void) const;
+            // Draw calls issued in the last frame, and how many of them
+            // were instanced draws with how many instances in total
+            int GetDrawCalls(void) const;
+            int GetInstancedDrawCalls(void) const;
+            int GetInstances(void) const;
+            // Draw calls that were multi-draws, which are included in
+            // the draw calls and instanced draw calls above
+            int GetMultiDrawCalls(void) const;
+            // Triangles and points drawn in the last frame, counting
+            // every instance
+            int GetTriangles(void) const;
+            int GetPoints(void) const;
+            // Buffers filled with instance data or commands in the last
+            // frame
+            int GetBufferUploads(void) const;
+
+            // Enable drawing runs of instanced batches with one
+            // glMultiDrawElementsIndirect (on by default)
+            void SetMultiDraw(bool enabled);
+            // Whether multi-draws are enabled and supported
+            bool UsesMultiDraw(void) const;
+
+        private:
+            // Sort entry: 64-bit key and index of the draw
+            // Bits 63-48: program, 47-40: vertex array, 39-24: texture,
+            // 23-0: first index of the geometry
+            struct SortKey {
+                GLuint64 key;
+                GLuint index;
+            };
+
+            // Run of sorted draws with the same state
+            struct Batch {
+                int first; // Position of the first draw in sorted order
+                int count; // Number of draws
+                const MaterialProgram *program; // Program used for the batch
+                GLuint vertex_array; // Geometry bound for that program
+                bool instanced; // Drawn with one instanced call
+                GLsizeiptr instance_offset; // Offset of its instance data
+                int first_command; // First command of a multi-draw
+                int num_commands; // Batches drawn by the multi-draw that
+                                  // starts here, or 0
+            };
+
+            // Layout of one command of glMultiDrawElementsIndirect
+            struct DrawElementsIndirectCommand {
+                GLuint count;
+                GLuint instanceCount;
+                GLuint firstIndex;
+                GLint baseVertex;
+                GLuint baseInstance;
+            };
+
+            // State left bound by the previous draws
+            struct BoundState {
+                const MaterialProgram *program;
+                GLuint vertex_array;
+                GLuint texture;
+            };
+
+            std::vector<DrawItem> item_; // Draws in traversal order
+            std::vector<SortKey> key_; // Draws in sorted order
+            std::vector<SortKey> temp_; // Scratch buffer for the sort
+            std::vector<Batch> batch_; // Batches of the sorted draws
+            std::vector<glm::mat4> instance_data_; // World and normal matrix of each instance
+            GLuint instance_buffer_; // Buffer streaming instance data
+            std::vector<DrawElementsIndirectCommand> command_; // Commands of the multi-draws
+            GLuint command_buffer_; // Buffer streaming the commands
+            bool multi_draw_; // Multi-draws are enabled
+            BoundState unsorted_state_; // State left by traversal order
+            int unsorted_changes_; // State changes in traversal order
+            int sorted_changes_; // State changes in sorted order
+            int draw_calls_; // Draw calls in the last frame
+            int instanced_draw_calls_;
+            int multi_draw_calls_;
+            int instances_;
+            int triangles_;
+            int points_;
+            int buffer_uploads_;
+
+            // Build the state key of a draw
+            static GLuint64 MakeKey(const DrawItem &item);
+            // Split the sorted draws into batches and gather the data of
+            // the instanced ones
+            void BuildBatches(void);
+            // Merge runs of instanced batches into multi-draw commands
+            void BuildCommands(void);
+            // Point the instance attributes of a program at a batch
+            void SetupInstances(const MaterialProgram *program, GLsizeiptr offset, GLState *gl_state);
+            // Add the primitives of a draw to the counts of the frame
+            void CountPrimitives(GLenum mode, GLsizei size, int instances);
+            // Number of state changes needed to issue a draw after the
+            // given state, which is updated to the state of the draw
+            static int CountChanges(BoundState &state, const MaterialProgram *program, GLuint vertex_array, GLuint texture);
+            // State before the first draw of a frame
+            static BoundState EmptyState(void);
+
+    }; // class RenderQueue
+
+} // namespace game
+
+#endif // RENDER_QUEUE_H_
@@ -0,0 +1,30 @@
+#include "render_stats.h"
+
+namespace game {
+
+RenderStats::RenderStats(void){
+
+    draw_calls = 0;
+    triangles = 0;
+    points = 0;
+    program_changes = 0;
+    buffer_uploads = 0;
+    texture_binds = 0;
+    uniform_uploads = 0;
+    nodes_traversed = 0;
+    nodes_drawn = 0;
+    nodes_skipped = 0;
+    present_interval = 0.0;
+}
+
+
+void RenderStats::Report(std::ostream &out) const {
+
+    out << "draw calls " << draw_calls << ", triangles " << triangles << ", points " << points
+        << ", program changes " << program_changes << ", buffer uploads " << buffer_uploads
+        << ", texture binds " << texture_binds << ", uniform uploads " << uniform_uploads
+        << ", nodes traversed " << nodes_traversed << ", drawn " << nodes_drawn
+        << ", skipped " << nodes_skipped << ", present interval " << present_interval << " ms" << std::endl;
+}
+
+} // namespace game
@@ -0,0 +1,33 @@
+#ifndef RENDER_STATS_H_
+#define RENDER_STATS_H_
+
+#include <ostream>
+
+namespace game {
+
+    // What the draw path submitted in one frame
+    struct RenderStats {
+        int draw_calls; // Draw calls, counting a multi-draw as one
+        int triangles; // Triangles drawn, counting every instance
+        int points; // Points drawn, counting every instance
+        int program_changes; // Programs made current
+        int buffer_uploads; // Buffers filled (frame block, instances, commands)
+        int texture_binds; // Textures bound; texture data is only
+                           // uploaded when loaded
+        int uniform_uploads; // Uniform values set
+        int nodes_traversed; // Nodes visited by culling, including the
+                             // roots of skipped subtrees
+        int nodes_drawn; // Drawable nodes that were queued
+        int nodes_skipped; // Drawable nodes that were culled
+        double present_interval; // Time since the previous present, in
+                                 // milliseconds
+
+        RenderStats(void);
+
+        // Print the counts on one line
+        void Report(std::ostream &out) const;
+    };
+
+} // namespace game
+
+#endif // RENDER_STATS_H_
@@ -1,4 +1,5 @@
 #include <exception>
+#include <stdexcept>
 
 #include "resource.h"
 
@@ -9,6 +10,28 @@ Resource::Resource(ResourceType type, std::string name, GLuint resource, GLsizei
     name_ = name;
     resource_ = resource;
     size_ = size;
+
+    // Shader programs are reflected once, when they become a resource
+    if (type == Material){
+        program_ = new MaterialProgram(resource);
+    } else {
+        program_ = NULL;
+    }
+    bounded_ = false;
+    sphere_ = InfiniteSphere();
+    arena_ = NULL;
+}
+
+
+Resource::Resource(std::string name, MaterialProgram *program){
+    type_ = Material;
+    name_ = name;
+    resource_ = program->GetProgram();
+    size_ = 0;
+    program_ = program;
+    bounded_ = false;
+    sphere_ = InfiniteSphere();
+    arena_ = NULL;
 }
 
 
@@ -18,11 +41,37 @@ Resource::Resource(ResourceType type, std::string name, GLuint array_buffer, GLu
     array_buffer_ = array_buffer;
     element_array_buffer_ = element_array_buffer;
     size_ = size;
+    program_ = NULL;
+    bounded_ = false;
+    sphere_ = InfiniteSphere();
+    arena_ = NULL;
+}
+
+
+Resource::Resource(ResourceType type, std::string name, GeometryArena *arena, const GeometryArena::Allocation &allocation){
+    type_ = type;
+    name_ = name;
+    array_buffer_ = 0;
+    element_array_buffer_ = 0;
+    size_ = allocation.indices.count;
+    program_ = NULL;
+    bounded_ = false;
+    sphere_ = InfiniteSphere();
+    arena_ = arena;
+    allocation_ = allocation;
 }
 
 
 Resource::~Resource(){
 
+    // Vertex arrays created for the layouts this geometry was drawn with
+    for (int i = 0; i < vertex_array_.size(); i++){
+        glDeleteVertexArrays(1, &vertex_array_[i].vao);
+    }
+    delete program_;
+    if (arena_){
+        arena_->Free(allocation_);
+    }
 }
 
 
@@ -46,12 +95,18 @@ GLuint Resource::GetResource(void) const {
 
 GLuint Resource::GetArrayBuffer(void) const {
 
+    if (arena_){
+        return arena_->GetArrayBuffer();
+    }
     return array_buffer_;
 }
 
 
 GLuint Resource::GetElementArrayBuffer(void) const {
 
+    if (arena_){
+        return arena_->GetElementArrayBuffer();
+    }
     return element_array_buffer_;
 }
 
@@ -61,4 +116,134 @@ GLsizei Resource::GetSize(void) const {
     return size_;
 }
 
+
+GLuint Resource::GetFirstIndex(void) const {
+
+    if (arena_){
+        return allocation_.indices.first;
+    }
+    return 0;
+}
+
+
+GLint Resource::GetBaseVertex(void) const {
+
+    if (arena_){
+        return allocation_.base_vertex;
+    }
+    return 0;
+}
+
+
+void Resource::ReadMesh(std::vector<GLfloat> &vertex, std::vector<GLuint> &index) const {
+
+    if (!arena_){
+        throw(std::invalid_argument(std::string("Geometry is not stored in the geometry arena: ")+name_));
+    }
+    arena_->Read(allocation_, vertex, index);
+}
+
+
+void Resource::SetBounds(const BoundingBox &box, const BoundingSphere &sphere){
+
+    bounded_ = true;
+    box_ = box;
+    sphere_ = sphere;
+}
+
+
+bool Resource::HasBounds(void) const {
+
+    return bounded_;
+}
+
+
+const BoundingBox &Resource::GetBoundingBox(void) const {
+
+    return box_;
+}
+
+
+const BoundingSphere &Resource::GetBoundingSphere(void) const {
+
+    return sphere_;
+}
+
+
+const MaterialProgram *Resource::GetMaterialProgram(void) const {
+
+    return program_;
+}
+
+
+GLuint Resource::GetVertexArray(const MaterialProgram *program) const {
+
+    // Geometry in the arena shares the vertex arrays of the arena
+    if (arena_){
+        return arena_->GetVertexArray(program);
+    }
+
+    // Find the vertex array already configured for this layout
+    GLuint layout = program->GetLayout();
+    for (int i = 0; i < vertex_array_.size(); i++){
+        if (vertex_array_[i].layout == layout){
+            return vertex_array_[i].vao;
+        }
+    }
+
+    // First time this geometry is drawn with this layout
+    VertexArray va;
+    va.layout = layout;
+    va.vao = CreateVertexArray(program);
+    vertex_array_.push_back(va);
+    return va.vao;
+}
+
+
+GLuint Resource::CreateVertexArray(const MaterialProgram *program) const {
+
+    // Record the buffers and the vertex format in a vertex array object
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    SetupVertexFormat(program, array_buffer_, (type_ == Mesh) ? element_array_buffer_ : 0);
+    glBindVertexArray(0);
+
+    return vao;
+}
+
+
+void Resource::SetupVertexFormat(const MaterialProgram *program, GLuint array_buffer, GLuint element_array_buffer){
+
+    // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
+    static const GLint components[num_vertex_attributes_g] = { 3, 3, 3, 2 };
+    static const int offset[num_vertex_attributes_g] = { 0, 3, 6, 9 };
+
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+    if (element_array_buffer > 0){
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
+    }
+
+    for (int i = 0; i < num_vertex_attributes_g; i++){
+        GLint att = program->GetAttribute((AttributeSlot) i);
+        if (att >= 0){
+            glVertexAttribPointer(att, components[i], GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (offset[i]*sizeof(GLfloat)));
+            glEnableVertexAttribArray(att);
+        }
+    }
+
+    // Per-instance matrices advance once per instance, one column per
+    // location; their buffer and offset are set by the render queue for
+    // each batch
+    for (int i = num_vertex_attributes_g; i < NumAttributeSlots; i++){
+        GLint att = program->GetAttribute((AttributeSlot) i);
+        if (att >= 0){
+            for (int c = 0; c < 4; c++){
+                glEnableVertexAttribArray(att + c);
+                glVertexAttribDivisor(att + c, 1);
+            }
+        }
+    }
+}
+
 } // namespace game
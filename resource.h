@@ -2,15 +2,42 @@
 #define RESOURCE_H_
 
 #include <string>
+#include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "material_program.h"
+#include "bounding_volume.h"
+#include "geometry_arena.h"
+
 namespace game {
 
     // Possible resource types
     typedef enum Type { Material, PointSet, Mesh, Texture } ResourceType;
 
+    // Position of a resource of one kind in its resource manager
+    // Handles are returned when resources are created, or resolved from
+    // names once at setup; they give back the resource without a search
+    template <ResourceType kind>
+    class ResourceHandle {
+
+        public:
+            ResourceHandle(void) : index_(-1) {}
+            explicit ResourceHandle(int index) : index_(index) {}
+
+            int GetIndex(void) const { return index_; }
+            bool IsValid(void) const { return index_ >= 0; }
+
+        private:
+            int index_; // Position in the manager, or -1 for no resource
+
+    }; // class ResourceHandle
+
+    typedef ResourceHandle<Mesh> MeshHandle; // Meshes and point sets
+    typedef ResourceHandle<Material> MaterialHandle;
+    typedef ResourceHandle<Texture> TextureHandle;
+
     // Class that holds one resource
     class Resource {
 
@@ -27,10 +54,29 @@ namespace game {
                 };
             };
             GLsizei size_; // Number of primitives in geometry
+            GeometryArena *arena_; // Arena holding the geometry, if any
+            GeometryArena::Allocation allocation_; // Place of the geometry in the arena
+            MaterialProgram *program_; // Reflected interface of a material
+            bool bounded_; // Whether the bounds of the geometry are known
+            BoundingBox box_; // Bounds of the geometry in its own frame
+            BoundingSphere sphere_;
+
+            // Vertex array objects of a geometry, one per material layout
+            struct VertexArray {
+                GLuint layout;
+                GLuint vao;
+            };
+            mutable std::vector<VertexArray> vertex_array_;
+
+            // Create a vertex array object describing the interleaved
+            // vertex format for the attribute locations of a program
+            GLuint CreateVertexArray(const MaterialProgram *program) const;
 
         public:
             Resource(ResourceType type, std::string name, GLuint resource, GLsizei size);
             Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            Resource(std::string name, MaterialProgram *program);
+            Resource(ResourceType type, std::string name, GeometryArena *arena, const GeometryArena::Allocation &allocation);
             ~Resource();
             ResourceType GetType(void) const;
             const std::string GetName(void) const;
@@ -38,6 +84,27 @@ namespace game {
             GLuint GetArrayBuffer(void) const;
             GLuint GetElementArrayBuffer(void) const;
             GLsizei GetSize(void) const;
+            // Position of the geometry in its buffers: first index, and
+            // value added to the indices when drawing
+            GLuint GetFirstIndex(void) const;
+            GLint GetBaseVertex(void) const;
+            // Read the vertices and indices of a mesh back from the
+            // geometry arena
+            void ReadMesh(std::vector<GLfloat> &vertex, std::vector<GLuint> &index) const;
+            const MaterialProgram *GetMaterialProgram(void) const;
+            // Get the vertex array object to draw this geometry with a
+            // material, creating it the first time the layout is seen
+            GLuint GetVertexArray(const MaterialProgram *program) const;
+            // Describe the interleaved vertex format in the currently bound
+            // vertex array object, for the attribute locations of a program
+            static void SetupVertexFormat(const MaterialProgram *program, GLuint array_buffer, GLuint element_array_buffer);
+            // Bounds of a geometry, set when it is created
+            // Geometry without bounds has an infinite sphere and is never
+            // culled
+            void SetBounds(const BoundingBox &box, const BoundingSphere &sphere);
+            bool HasBounds(void) const;
+            const BoundingBox &GetBoundingBox(void) const;
+            const BoundingSphere &GetBoundingSphere(void) const;
 
     }; // class Resource
 
@@ -7,6 +7,7 @@
 #include <SOIL/SOIL.h>
 
 #include "resource_manager.h"
+#include "profiler.h"
 
 namespace game {
 
@@ -24,7 +25,7 @@ void ResourceManager::AddResource(ResourceType type, const std::string name, GLu
 
     res = new Resource(type, name, resource, size);
 
-    resource_.push_back(res);
+    Add(res);
 }
 
 
@@ -34,7 +35,55 @@ void ResourceManager::AddResource(ResourceType type, const std::string name, GLu
 
     res = new Resource(type, name, array_buffer, element_array_buffer, size);
 
-    resource_.push_back(res);
+    Add(res);
+}
+
+
+void ResourceManager::AddResource(const std::string name, MaterialProgram *program){
+
+    Resource *res;
+
+    res = new Resource(name, program);
+
+    Add(res);
+}
+
+
+MeshHandle ResourceManager::AddMesh(const std::string name, const GLfloat *vertex, GLuint vertex_num, const GLuint *index, GLuint index_num){
+
+    // Vertices and indices are suballocated from the shared buffers
+    GeometryArena::Allocation allocation = arena_.Allocate(vertex, vertex_num, index, index_num);
+    Resource *res = new Resource(Mesh, name, &arena_, allocation);
+
+    // Bounds of the mesh, used to cull it against the view
+    BoundingBox box = ComputeBoundingBox(vertex, vertex_num, 11);
+    res->SetBounds(box, ComputeBoundingSphere(vertex, vertex_num, 11, box));
+
+    return MeshHandle(Add(res));
+}
+
+
+void ResourceManager::RemoveMesh(MeshHandle handle){
+
+    Resource *res = GetAt(handle.GetIndex());
+    if (!res){
+        return;
+    }
+
+    // The name may belong to an older resource added under it first
+    std::unordered_map<std::string, int>::iterator it = index_.find(res->GetName());
+    if ((it != index_.end()) && (it->second == handle.GetIndex())){
+        index_.erase(it);
+    }
+    resource_[handle.GetIndex()] = NULL;
+    free_index_.push_back(handle.GetIndex());
+    delete res;
+}
+
+
+const GeometryArena &ResourceManager::GetGeometryArena(void) const {
+
+    return arena_;
 }
 
 
@@ -54,17 +103,96 @@ void ResourceManager::LoadResource(ResourceType type, const std::string name, co
 Resource *ResourceManager::GetResource(const std::string name) const {
 
     // Find resource with the specified name
-    for (int i = 0; i < resource_.size(); i++){
-        if (resource_[i]->GetName() == name){
-            return resource_[i];
-        }
+    std::unordered_map<std::string, int>::const_iterator it = index_.find(name);
+    if (it == index_.end()){
+        return NULL;
     }
-    return NULL;
+    return resource_[it->second];
+}
+
+
+MeshHandle ResourceManager::GetMesh(const std::string name) const {
+
+    return MeshHandle(Find(name, Mesh, PointSet));
 }
 
 
-void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
+MaterialHandle ResourceManager::GetMaterial(const std::string name) const {
+
+    return MaterialHandle(Find(name, Material, Material));
+}
+
 
+TextureHandle ResourceManager::GetTexture(const std::string name) const {
+
+    return TextureHandle(Find(name, Texture, Texture));
+}
+
+
+Resource *ResourceManager::GetResource(MeshHandle handle) const {
+
+    return GetAt(handle.GetIndex());
+}
+
+
+Resource *ResourceManager::GetResource(MaterialHandle handle) const {
+
+    return GetAt(handle.GetIndex());
+}
+
+
+Resource *ResourceManager::GetResource(TextureHandle handle) const {
+
+    return GetAt(handle.GetIndex());
+}
+
+
+int ResourceManager::Add(Resource *res){
+
+    // Slots of removed resources are reused, so that the list does not
+    // grow when meshes are created and removed in turn
+    int index;
+    if (free_index_.size() > 0){
+        index = free_index_.back();
+        free_index_.pop_back();
+        resource_[index] = res;
+    } else {
+        index = resource_.size();
+        resource_.push_back(res);
+    }
+
+    // A name that is already taken keeps pointing at the first resource
+    index_.insert(std::make_pair(res->GetName(), index));
+    return index;
+}
+
+
+int ResourceManager::Find(const std::string name, ResourceType type, ResourceType other_type) const {
+
+    std::unordered_map<std::string, int>::const_iterator it = index_.find(name);
+    if (it == index_.end()){
+        return -1;
+    }
+    ResourceType found = resource_[it->second]->GetType();
+    if ((found != type) && (found != other_type)){
+        return -1;
+    }
+    return it->second;
+}
+
+
+Resource *ResourceManager::GetAt(int index) const {
+
+    if ((index < 0) || (index >= resource_.size())){
+        return NULL;
+    }
+    return resource_[index];
+}
+
+
+MaterialHandle ResourceManager::LoadMaterial(const std::string name, const char *prefix){
+
+    PROFILE_ZONE("Load material");
     // Load vertex program source code
     std::string filename = std::string(prefix) + std::string(VERTEX_PROGRAM_EXTENSION);
     std::string vp = LoadTextFile(filename.c_str());
@@ -73,6 +201,40 @@ void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
     filename = std::string(prefix) + std::string(FRAGMENT_PROGRAM_EXTENSION);
     std::string fp = LoadTextFile(filename.c_str());
 
+    // Read the camera and time from the per-frame uniform block when
+    // uniform buffers are available (OpenGL 3.1)
+    if (GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object){
+        vp = AddDefine(vp, "FRAME_BLOCK");
+    }
+
+    // Create the shader program
+    GLuint sp = CreateProgram(vp, fp);
+
+    // Create the instanced variant of the material, which reads its
+    // transformations from per-instance attributes
+    // It needs instanced arrays (OpenGL 3.3); without them, or if the
+    // variant does not build, nodes are drawn one at a time
+    GLuint isp = 0;
+    if (GLEW_VERSION_3_3){
+        try {
+            isp = CreateProgram(AddDefine(vp, "INSTANCED"), fp);
+        }
+        catch (std::exception &e){
+            isp = 0;
+        }
+    }
+
+    // Add a resource for the shader program
+    // The resource reflects the active attributes and uniforms once, so
+    // nodes using this material never query locations by name
+    MaterialProgram *program = new MaterialProgram(sp, isp);
+    program->SetName(name);
+    return MaterialHandle(Add(new Resource(name, program)));
+}
+
+
+GLuint ResourceManager::CreateProgram(const std::string vp, const std::string fp){
+
     // Create a shader from the vertex program source code
     GLuint vs = glCreateShader(GL_VERTEX_SHADER);
     const char *source_vp = vp.c_str();
@@ -107,6 +269,7 @@ void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
     GLuint sp = glCreateProgram();
     glAttachShader(sp, vs);
     glAttachShader(sp, fs);
+    MaterialProgram::BindAttributeLocations(sp);
     glLinkProgram(sp);
 
     // Check if shaders were linked successfully
@@ -122,8 +285,18 @@ void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
     glDeleteShader(vs);
     glDeleteShader(fs);
 
-    // Add a resource for the shader program
-    AddResource(Material, name, sp, 0);
+    return sp;
+}
+
+
+std::string ResourceManager::AddDefine(const std::string source, const std::string define){
+
+    // Defines must follow the version directive, which comes first
+    std::string::size_type line_end = source.find('\n');
+    if ((source.compare(0, 8, "#version") != 0) || (line_end == std::string::npos)){
+        throw(std::invalid_argument(std::string("Shader source does not start with a version directive")));
+    }
+    return source.substr(0, line_end + 1) + std::string("#define ") + define + std::string("\n") + source.substr(line_end + 1);
 }
 
 
@@ -150,8 +323,9 @@ std::string ResourceManager::LoadTextFile(const char *filename){
 }
 
 
-void ResourceManager::LoadTexture(const std::string name, const char *filename){
+TextureHandle ResourceManager::LoadTexture(const std::string name, const char *filename){
 
+    PROFILE_ZONE("Load texture");
     // Load image from file using SOIL
     int width, height;
     unsigned char* image = SOIL_load_image(filename, &width, &height, 0, SOIL_LOAD_RGBA);
@@ -162,6 +336,57 @@ void ResourceManager::LoadTexture(const std::string name, const char *filename){
     // Create OpenGL texture
     GLuint texture;
     glGenTextures(1, &texture);
+    UploadImage(texture, image, width, height);
+
+    // Free image data
+    SOIL_free_image_data(image);
+
+    // Add texture resource
+    return TextureHandle(Add(new Resource(Texture, name, texture, 0)));
+}
+
+
+TextureHandle ResourceManager::QueueTexture(const std::string name, const char *filename){
+
+    // The texture object exists from now on, so that the resource can be
+    // used right away; its image is uploaded once decoded
+    GLuint texture;
+    glGenTextures(1, &texture);
+    int index = Add(new Resource(Texture, name, texture, 0));
+    loader_.Queue(index, filename);
+    return TextureHandle(index);
+}
+
+
+void ResourceManager::UploadTextures(void){
+
+    TakeTextures(false);
+}
+
+
+void ResourceManager::FinishTextures(void){
+
+    PROFILE_ZONE("Wait for textures");
+    TakeTextures(true);
+}
+
+
+void ResourceManager::TakeTextures(bool wait){
+
+    TextureLoader::Image image;
+    while (loader_.Take(image, wait)){
+        if (!image.data){
+            throw(std::ios_base::failure(std::string("Error loading texture file: ")+image.filename+std::string(" - ")+image.error));
+        }
+        PROFILE_ZONE("Upload texture");
+        UploadImage(resource_[image.index]->GetResource(), image.data, image.width, image.height);
+        SOIL_free_image_data(image.data);
+    }
+}
+
+
+void ResourceManager::UploadImage(GLuint texture, const unsigned char *image, int width, int height){
+
     glBindTexture(GL_TEXTURE_2D, texture);
 
     // Upload texture data
@@ -172,16 +397,10 @@ void ResourceManager::LoadTexture(const std::string name, const char *filename){
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Free image data
-    SOIL_free_image_data(image);
-
-    // Add texture resource
-    AddResource(Texture, name, texture, 0);
 }
 
 
-void ResourceManager::CreateTorus(std::string object_name, float loop_radius, float circle_radius, int num_loop_samples, int num_circle_samples){
+MeshHandle ResourceManager::CreateTorus(std::string object_name, float loop_radius, float circle_radius, int num_loop_samples, int num_circle_samples){
 
     // Create a torus
     // The torus is built from a large loop with small circles around the loop
@@ -264,30 +483,18 @@ void ResourceManager::CreateTorus(std::string object_name, float loop_radius, fl
         }
     }
 
-    // Create OpenGL buffers and copy data
-    //GLuint vao;
-    //glGenVertexArrays(1, &vao);
-    //glBindVertexArray(vao);
-
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
+    // Copy the mesh into the shared geometry arena
+    MeshHandle handle = AddMesh(object_name, vertex, vertex_num, face, face_num * face_att);
 
     // Free data buffers
     delete [] vertex;
     delete [] face;
 
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+    return handle;
 }
 
 
-void ResourceManager::CreateSphere(std::string object_name, float radius, int num_samples_theta, int num_samples_phi){
+MeshHandle ResourceManager::CreateSphere(std::string object_name, float radius, int num_samples_theta, int num_samples_phi){
 
     // Create a sphere using a well-known parameterization
 
@@ -366,30 +573,18 @@ void ResourceManager::CreateSphere(std::string object_name, float radius, int nu
         }
     }
 
-    // Create OpenGL buffers and copy data
-    //GLuint vao;
-    //glGenVertexArrays(1, &vao);
-    //glBindVertexArray(vao);
-
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
+    // Copy the mesh into the shared geometry arena
+    MeshHandle handle = AddMesh(object_name, vertex, vertex_num, face, face_num * face_att);
 
     // Free data buffers
     delete [] vertex;
     delete [] face;
 
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+    return handle;
 }
 
 
-void ResourceManager::CreateCylindricalGeometry(std::string object_name, float top_radius, float bottom_radius, float height, int linear_samples, int circle_samples) {
+MeshHandle ResourceManager::CreateCylindricalGeometry(std::string object_name, float top_radius, float bottom_radius, float height, int linear_samples, int circle_samples) {
 
     if (linear_samples < 2) { linear_samples = 2; }
 
@@ -526,26 +721,18 @@ void ResourceManager::CreateCylindricalGeometry(std::string object_name, float t
         }
     }
 
-    // Create OpenGL buffers and copy data
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
+    // Copy the mesh into the shared geometry arena
+    MeshHandle handle = AddMesh(object_name, vertex, vertex_num, face, face_num * face_att);
 
     // Free data buffers
     delete[] vertex;
     delete[] face;
 
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+    return handle;
 }
 
 // Create the geometry for a cube centered at (0, 0, 0) with sides of length 1
-void ResourceManager::CreateCube(std::string object_name){
+MeshHandle ResourceManager::CreateCube(std::string object_name){
 
     // This construction uses shared vertices, following the same data
     // format as the other functions 
@@ -610,18 +797,8 @@ void ResourceManager::CreateCube(std::string object_name){
         20, 22, 23,
     };
 
-    // Create OpenGL buffers and copy data
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertex), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(face), face, GL_STATIC_DRAW);
-
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, sizeof(face) / sizeof(GLfloat));
+    // Copy the mesh into the shared geometry arena
+    return AddMesh(object_name, vertex, sizeof(vertex) / (11 * sizeof(GLfloat)), face, sizeof(face) / sizeof(GLuint));
 }
 
 } // namespace game;
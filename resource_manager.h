@@ -2,12 +2,14 @@
 #define RESOURCE_MANAGER_H_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include "resource.h"
+#include "texture_loader.h"
 
 // Default extensions for different shader source files
 #define VERTEX_PROGRAM_EXTENSION "_vp.glsl"
@@ -25,32 +27,89 @@ namespace game {
             // Add a resource that was already loaded and allocated to memory
             void AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size);
             void AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            void AddResource(const std::string name, MaterialProgram *program);
+            // Add a mesh, copying its interleaved vertices and its indices
+            // into the shared geometry arena
+            MeshHandle AddMesh(const std::string name, const GLfloat *vertex, GLuint vertex_num, const GLuint *index, GLuint index_num);
+            // Delete a mesh and return its space to the geometry arena
+            // Its handle then gives no resource until its slot is taken
+            // by the next resource added, and its name is free
+            void RemoveMesh(MeshHandle handle);
             // Load a resource from a file, according to the specified type
             void LoadResource(ResourceType type, const std::string name, const char *filename);
+            // Load shaders programs
+            MaterialHandle LoadMaterial(const std::string name, const char *prefix);
+            // Load a texture from an image file
+            TextureHandle LoadTexture(const std::string name, const char *filename);
+            // Queue a texture to be decoded on worker threads, and return
+            // its handle at once
+            // The texture stays empty until uploaded by UploadTextures()
+            // or FinishTextures()
+            TextureHandle QueueTexture(const std::string name, const char *filename);
+            // Upload the queued textures already decoded, without waiting
+            void UploadTextures(void);
+            // Upload all queued textures, waiting for their decoding
+            void FinishTextures(void);
             // Get the resource with the specified name
+            // Names are hashed; when several resources share a name, the
+            // first one added is found
             Resource *GetResource(const std::string name) const;
+            // Handle of the resource with the specified name, or an
+            // invalid handle if there is none of that kind
+            MeshHandle GetMesh(const std::string name) const;
+            MaterialHandle GetMaterial(const std::string name) const;
+            TextureHandle GetTexture(const std::string name) const;
+            // Get the resource of a handle, or NULL for an invalid handle
+            Resource *GetResource(MeshHandle handle) const;
+            Resource *GetResource(MaterialHandle handle) const;
+            Resource *GetResource(TextureHandle handle) const;
+            // Buffers holding all meshes, with their occupancy
+            const GeometryArena &GetGeometryArena(void) const;
 
             // Methods to create specific resources
             // Create the geometry for a torus and add it to the list of resources
-            void CreateTorus(std::string object_name, float loop_radius = 0.6, float circle_radius = 0.2, int num_loop_samples = 90, int num_circle_samples = 30);
+            MeshHandle CreateTorus(std::string object_name, float loop_radius = 0.6, float circle_radius = 0.2, int num_loop_samples = 90, int num_circle_samples = 30);
             // Create a sphere
-            void CreateSphere(std::string object_name, float radius = 0.6, int num_samples_theta = 90, int num_samples_phi = 45);
+            MeshHandle CreateSphere(std::string object_name, float radius = 0.6, int num_samples_theta = 90, int num_samples_phi = 45);
             // Create cylindrical geometry
-            void CreateCylindricalGeometry(std::string object_name, float top_radius = 0.5, float bottom_radius = 0.5, float height = 0.5, int linear_samples = 7, int circle_samples = 32);
+            MeshHandle CreateCylindricalGeometry(std::string object_name, float top_radius = 0.5, float bottom_radius = 0.5, float height = 0.5, int linear_samples = 7, int circle_samples = 32);
             // Create cube centered at (0, 0, 0) with sides of length 1
-            void CreateCube(std::string object_name);
+            MeshHandle CreateCube(std::string object_name);
 
         private:
-            // List storing all resources
+            // Buffers shared by all meshes
+            GeometryArena arena_;
+            // Images being decoded for queued textures
+            TextureLoader loader_;
+
+            // List storing all resources, indexed by handles
             std::vector<Resource*> resource_;
+            // Position of each resource in the list, by name
+            std::unordered_map<std::string, int> index_;
+            // Positions left empty by removed resources, reused first
+            std::vector<int> free_index_;
 
-            // Methods to load specific types of resources
-            // Load shaders programs
-            void LoadMaterial(const std::string name, const char *prefix);
-            // Load a texture from an image file
-            void LoadTexture(const std::string name, const char *filename);
+            // Add a resource to the list, and return its position
+            int Add(Resource *res);
+            // Position of the resource with a name and of one of the
+            // given types, or -1
+            int Find(const std::string name, ResourceType type, ResourceType other_type) const;
+            // Resource at a position, or NULL
+            Resource *GetAt(int index) const;
+
+            // Helpers to load resources
+            // Upload a decoded image to a texture
+            static void UploadImage(GLuint texture, const unsigned char *image, int width, int height);
+            // Upload the textures decoded by the loader, optionally
+            // waiting for all of them
+            void TakeTextures(bool wait);
             // Load a text file into memory (could be source code)
             std::string LoadTextFile(const char *filename);
+            // Compile and link a shader program from its source code
+            GLuint CreateProgram(const std::string vp, const std::string fp);
+            // Insert a preprocessor define right after the version directive
+            // of a shader, to select one of its variants
+            static std::string AddDefine(const std::string source, const std::string define);
 
     }; // class ResourceManager
 
@@ -1,19 +1,23 @@
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
-#include <stack>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "scene_graph.h"
+#include "profiler.h"
 
 namespace game {
 
 SceneGraph::SceneGraph(void){
 
     background_color_ = glm::vec3(0.0, 0.0, 0.0);
+    visible_nodes_ = 0;
+    culled_nodes_ = 0;
+    culled_subtrees_ = 0;
+    traversed_nodes_ = 0;
 }
 
 
@@ -36,79 +40,181 @@ glm::vec3 SceneGraph::GetBackgroundColor(void) const {
 void SceneGraph::SetRoot(SceneNode *node){
 
     root_ = node;
+    hierarchy_.Build(node);
 }
 
 
-SceneNode *SceneGraph::GetNode(std::string node_name) const {
+SceneNode *SceneGraph::GetNode(std::string node_name){
 
     // Find node with the specified name
-    std::stack<SceneNode *> stck;
-    stck.push(root_);
-    while (stck.size() > 0){
-        SceneNode *current = stck.top();
-        stck.pop();
-        if (current->GetName() == node_name){
-            return current;
-        }
-        for (std::vector<SceneNode *>::const_iterator it = current->children_begin();
-             it != current->children_end(); it++){
-            stck.push(*it);
+    hierarchy_.Update();
+    for (int i = 0; i < hierarchy_.GetSize(); i++){
+        if (hierarchy_.GetNode(i)->GetName() == node_name){
+            return hierarchy_.GetNode(i);
         }
     }
     return NULL;
 }
 
 
-void SceneGraph::Draw(Camera *camera){
+void SceneGraph::Draw(Camera *camera, float time){
+
+    gpu_timer_.BeginFrame();
 
     // Clear background
     glClearColor(background_color_[0], 
                  background_color_[1],
                  background_color_[2], 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gpu_timer_.Mark("Clear");
+
+    // Set up the view and the per-frame uniform block once
+    camera->SetupFrame(time);
+
+    // Find and sort the draws, then issue them
+    Collect(camera);
+    PROFILE_ZONE("Submit");
+    gl_state_.ResetCounters();
+    queue_.Submit(camera, &gl_state_, &gpu_timer_);
+    gpu_timer_.EndFrame();
+
+    // Gather the counts of the frame
+    stats_.draw_calls = queue_.GetDrawCalls();
+    stats_.triangles = queue_.GetTriangles();
+    stats_.points = queue_.GetPoints();
+    stats_.program_changes = gl_state_.GetProgramChanges();
+    stats_.buffer_uploads = queue_.GetBufferUploads() + (camera->HasFrameBlock() ? 1 : 0);
+    stats_.texture_binds = gl_state_.GetTextureBinds();
+    stats_.uniform_uploads = gl_state_.GetUniformUploads();
+    stats_.nodes_traversed = traversed_nodes_;
+    stats_.nodes_drawn = visible_nodes_;
+    stats_.nodes_skipped = culled_nodes_;
+}
+
+
+void SceneGraph::Collect(const Camera *camera){
+
+    // Bring all world transformations up to date in one pass
+    {
+        PROFILE_ZONE("Transform update");
+        hierarchy_.Update();
+    }
 
-    // Draw all scene nodes
-    // Initialize stack of nodes
-    std::stack<SceneNode *> stck;
-    stck.push(root_);
-    // Initialize stack of transformations
-    std::stack<glm::mat4> transf;
-    transf.push(glm::mat4(1.0));
-    // Traverse hierarchy
-    while (stck.size() > 0){
-        // Get next node to be processed and pop it from the stack
-        SceneNode *current = stck.top();
-        stck.pop();
-        // Get transformation corresponding to the parent of the next node
-        glm::mat4 parent_transf = transf.top();
-        transf.pop();
-        // Draw node based on parent transformation
-        glm::mat4 current_transf = current->Draw(camera, parent_transf);
-        // Push children of the node to the stack, along with the node's
-        // transformation
-        for (std::vector<SceneNode *>::const_iterator it = current->children_begin();
-             it != current->children_end(); it++){
-            stck.push(*it);
-            transf.push(current_transf);
+    // Collect the draws of all scene nodes inside the view volume
+    queue_.Clear();
+    Frustum frustum = camera->GetFrustum();
+    visible_nodes_ = 0;
+    culled_nodes_ = 0;
+    culled_subtrees_ = 0;
+    traversed_nodes_ = 0;
+    {
+        PROFILE_ZONE("Cull");
+        // Traverse hierarchy in depth-first order
+        int i = 0;
+        while (i < hierarchy_.GetSize()){
+            SceneNode *current = hierarchy_.GetNode(i);
+            traversed_nodes_++;
+            // Skip the whole subtree if its bounds are outside of the view
+            if (frustum.IsOutside(current->GetWorldBounds())){
+                culled_nodes_ += current->GetNumDrawables();
+                culled_subtrees_++;
+                i = hierarchy_.GetSubtreeEnd(i);
+                continue;
+            }
+            // Queue node with its cached world transformation
+            int queued = queue_.GetSize();
+            current->Draw(&queue_, frustum);
+            if (queue_.GetSize() > queued){
+                visible_nodes_++;
+            } else if (current->IsDrawable()){
+                culled_nodes_++;
+            }
+            i++;
         }
     }
+
+    // Group draws by program, geometry and texture
+    PROFILE_ZONE("Sort");
+    queue_.Sort();
+}
+
+
+void SceneGraph::Update(float delta_time){
+
+    // Update all nodes, in depth-first order
+    PROFILE_ZONE("Scene update");
+    hierarchy_.Update();
+    for (int i = 0; i < hierarchy_.GetSize(); i++){
+        hierarchy_.GetNode(i)->Update(delta_time);
+    }
+}
+
+
+void SceneGraph::BeginStep(void){
+
+    hierarchy_.BeginStep();
+}
+
+
+void SceneGraph::SetBlend(float blend){
+
+    hierarchy_.SetBlend(blend);
+}
+
+
+const RenderQueue &SceneGraph::GetRenderQueue(void) const {
+
+    return queue_;
 }
 
 
-void SceneGraph::Update(void){
+const GLState &SceneGraph::GetGLState(void) const {
 
-    // Traverse hierarchy to update all nodes
-    std::stack<SceneNode *> stck;
-    stck.push(root_);
-    while (stck.size() > 0){
-        SceneNode *current = stck.top();
-        stck.pop();
-        current->Update();
-        for (std::vector<SceneNode *>::const_iterator it = current->children_begin();
-             it != current->children_end(); it++){
-            stck.push(*it);
+    return gl_state_;
+}
+
+
+const GpuTimer &SceneGraph::GetGpuTimer(void) const {
+
+    return gpu_timer_;
+}
+
+
+unsigned int SceneGraph::GetChecksum(void) const {
+
+    // FNV-1a over the bits of the matrices, so that any difference counts
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < hierarchy_.GetSize(); i++){
+        const unsigned char *bytes = (const unsigned char *) glm::value_ptr(hierarchy_.GetWorldTransform(i));
+        for (int j = 0; j < sizeof(glm::mat4); j++){
+            hash = (hash ^ bytes[j])*16777619u;
         }
     }
+    return hash;
+}
+
+
+int SceneGraph::GetVisibleNodes(void) const {
+
+    return visible_nodes_;
+}
+
+
+int SceneGraph::GetCulledNodes(void) const {
+
+    return culled_nodes_;
+}
+
+
+int SceneGraph::GetCulledSubtrees(void) const {
+
+    return culled_subtrees_;
+}
+
+
+const RenderStats &SceneGraph::GetRenderStats(void) const {
+
+    return stats_;
 }
 
 } // namespace game
@@ -10,6 +10,11 @@
 #include "scene_node.h"
 #include "resource.h"
 #include "camera.h"
+#include "render_queue.h"
+#include "render_stats.h"
+#include "gl_state.h"
+#include "gpu_timer.h"
+#include "transform_hierarchy.h"
 
 namespace game {
 
@@ -23,6 +28,27 @@ namespace game {
             // Root of the hierarchy
             SceneNode * root_;
 
+            // Flattened copy of the hierarchy, traversed linearly
+            TransformHierarchy hierarchy_;
+
+            // Draws collected from the hierarchy, sorted by state
+            RenderQueue queue_;
+
+            // Shadow copy of the OpenGL state, used to drop redundant calls
+            GLState gl_state_;
+
+            // GPU time of the clear and of each material
+            GpuTimer gpu_timer_;
+
+            // Culling results of the last frame
+            int visible_nodes_; // Drawable nodes inside the view
+            int culled_nodes_; // Drawable nodes skipped
+            int culled_subtrees_; // Subtrees skipped as a whole
+            int traversed_nodes_; // Nodes visited, including skipped subtree roots
+
+            // Counts of what the last frame submitted
+            RenderStats stats_;
+
         public:
             SceneGraph(void);
             ~SceneGraph();
@@ -34,13 +60,47 @@ namespace game {
             // Set root of the hierarchy
             void SetRoot(SceneNode *node);
             // Find a scene node with a specific name
-            SceneNode *GetNode(std::string node_name) const;
+            SceneNode *GetNode(std::string node_name);
+
+            // Draw the entire scene, at a time in seconds for the
+            // animated uniforms
+            void Draw(Camera *camera, float time);
+            // Fill the render queue with the sorted draws of the nodes
+            // inside the view of the camera, without drawing anything
+            // Draw() does it after setting up the frame
+            void Collect(const Camera *camera);
+
+            // Advance the entire scene by one simulation step
+            void Update(float delta_time);
+            // Keep the current state of the nodes as the previous step,
+            // before a new simulation step
+            void BeginStep(void);
+            // Draw the nodes at this fraction of the way from the previous
+            // step to the current one
+            void SetBlend(float blend);
+
+            // Draws submitted in the last frame, with the number of state
+            // changes removed by sorting them
+            const RenderQueue &GetRenderQueue(void) const;
+
+            // State cache, with the calls it dropped and issued
+            const GLState &GetGLState(void) const;
+            // GPU time of the parts of a recent frame
+            const GpuTimer &GetGpuTimer(void) const;
+
+            // Hash of the world transformations of all nodes, as of the
+            // last frame drawn
+            unsigned int GetChecksum(void) const;
 
-            // Draw the entire scene
-            void Draw(Camera *camera);
+            // Drawable nodes that were queued and that were culled in the
+            // last frame, and how many subtrees were skipped entirely
+            int GetVisibleNodes(void) const;
+            int GetCulledNodes(void) const;
+            int GetCulledSubtrees(void) const;
 
-            // Update entire scene
-            void Update(void);
+            // Draw calls, primitives, state changes, uploads and nodes
+            // of the last frame drawn
+            const RenderStats &GetRenderStats(void) const;
 
     }; // class SceneGraph
 
@@ -24,10 +24,12 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
             throw(std::invalid_argument(std::string("Invalid type of geometry")));
         }
 
+        geometry_ = geometry;
         array_buffer_ = geometry->GetArrayBuffer();
         element_array_buffer_ = geometry->GetElementArrayBuffer();
         size_ = geometry->GetSize();
     } else {
+        geometry_ = NULL;
         array_buffer_ = 0;
     }
 
@@ -38,8 +40,10 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
         }
 
         material_ = material->GetResource();
+        program_ = material->GetMaterialProgram();
     } else {
         material_ = 0;
+        program_ = NULL;
     }
 
     // Initialize texture to 0 (no texture)
@@ -50,6 +54,14 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
 
     // Hierarchy
     parent_ = NULL;
+
+    // The node is not part of a flattened hierarchy until it is added
+    // to a scene
+    hierarchy_ = NULL;
+    index_ = -1;
+
+    // Bounds are computed on first use
+    bounds_dirty_ = true;
 }
 
 
@@ -65,55 +77,88 @@ const std::string SceneNode::GetName(void) const {
 
 glm::vec3 SceneNode::GetPosition(void) const {
 
+    if (hierarchy_){
+        return hierarchy_->GetPosition(index_);
+    }
     return position_;
 }
 
 
 glm::quat SceneNode::GetOrientation(void) const {
 
+    if (hierarchy_){
+        return hierarchy_->GetOrientation(index_);
+    }
     return orientation_;
 }
 
 
 glm::vec3 SceneNode::GetScale(void) const {
 
+    if (hierarchy_){
+        return hierarchy_->GetScale(index_);
+    }
     return scale_;
 }
 
 
 void SceneNode::SetPosition(glm::vec3 position){
 
-    position_ = position;
+    if (hierarchy_){
+        hierarchy_->SetPosition(index_, position);
+    } else {
+        position_ = position;
+    }
+    InvalidateBounds();
 }
 
 
 void SceneNode::SetOrientation(glm::quat orientation){
 
-    orientation_ = orientation;
+    if (hierarchy_){
+        hierarchy_->SetOrientation(index_, orientation);
+    } else {
+        orientation_ = orientation;
+    }
+    InvalidateBounds();
 }
 
 
 void SceneNode::SetScale(glm::vec3 scale){
 
-    scale_ = scale;
+    if (hierarchy_){
+        hierarchy_->SetScale(index_, scale);
+    } else {
+        scale_ = scale;
+    }
+    InvalidateBounds();
+}
+
+
+void SceneNode::Teleport(glm::vec3 position){
+
+    SetPosition(position);
+    if (hierarchy_){
+        hierarchy_->ResetMotion(index_);
+    }
 }
 
 
 void SceneNode::Translate(glm::vec3 trans){
 
-    position_ += trans;
+    SetPosition(GetPosition() + trans);
 }
 
 
 void SceneNode::Rotate(glm::quat rot){
 
-    orientation_ *= rot;
+    SetOrientation(GetOrientation() * rot);
 }
 
 
 void SceneNode::Scale(glm::vec3 scale){
 
-    scale_ *= scale;
+    SetScale(GetScale() * scale);
 }
 
 
@@ -147,95 +192,180 @@ GLuint SceneNode::GetMaterial(void) const {
 }
 
 
-glm::mat4 SceneNode::Draw(Camera *camera, glm::mat4 parent_transf){
+void SceneNode::Draw(RenderQueue *queue, const Frustum &frustum){
 
-    if ((array_buffer_ > 0) && (material_ > 0)){
-        // Select proper material (shader program)
-        glUseProgram(material_);
+    if (IsDrawable()){
+        const glm::mat4 &world_mat = GetWorldMatrix();
 
-        // Set geometry to draw
-        glBindBuffer(GL_ARRAY_BUFFER, array_buffer_);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+        // The subtree bounds were already tested, so only the box of
+        // the geometry itself can still reject the node
+        if (geometry_->HasBounds() && frustum.IsOutside(geometry_->GetBoundingBox(), world_mat)){
+            return;
+        }
 
-        // Set globals for camera
-        camera->SetupShader(material_);
+        DrawItem item;
+        item.program = program_;
+        item.geometry = geometry_;
+        // The vertex array object already holds the buffers and the
+        // vertex format for this material's attribute layout
+        item.vertex_array = geometry_->GetVertexArray(program_);
+        item.texture = texture_;
+        item.mode = mode_;
+        item.size = size_;
 
-        // Set world matrix and other shader input variables
-        glm::mat4 transf = SetupShader(material_, parent_transf);
+        item.world_mat = world_mat;
+        item.normal_mat = GetNormalMatrix();
 
-        // Draw geometry
-        if (mode_ == GL_POINTS){
-            glDrawArrays(mode_, 0, size_);
-        } else {
-            glDrawElements(mode_, size_, GL_UNSIGNED_INT, 0);
-        }
+        queue->Add(item);
+    }
+}
 
-        return transf;
-    } else {
-        glm::mat4 rotation = glm::mat4_cast(orientation_);
-        glm::mat4 translation = glm::translate(glm::mat4(1.0), position_);
-        glm::mat4 transf = parent_transf * translation * rotation;
-        return transf;
+
+glm::mat4 SceneNode::GetLocalTransform(void) const {
+
+    glm::mat4 rotation = glm::mat4_cast(GetOrientation());
+    glm::mat4 translation = glm::translate(glm::mat4(1.0), GetPosition());
+    return translation * rotation;
+}
+
+
+const glm::mat4 &SceneNode::GetWorldTransform(void){
+
+    if (UpdateHierarchy()){
+        return hierarchy_->GetWorldTransform(index_);
     }
+    ComputeTransforms();
+    return world_transf_;
 }
 
 
-void SceneNode::Update(void){
+const glm::mat4 &SceneNode::GetWorldMatrix(void){
 
-    // Do nothing for this generic type of scene node
+    if (UpdateHierarchy()){
+        return hierarchy_->GetWorldMatrix(index_);
+    }
+    ComputeTransforms();
+    return world_mat_;
+}
+
+
+const glm::mat4 &SceneNode::GetNormalMatrix(void){
+
+    if (UpdateHierarchy()){
+        return hierarchy_->GetNormalMatrix(index_);
+    }
+    ComputeTransforms();
+    return normal_mat_;
+}
+
+
+bool SceneNode::UpdateHierarchy(void){
+
+    // The update may rebuild the hierarchy, which moves the node to
+    // another index or takes it out
+    if (hierarchy_){
+        hierarchy_->Update();
+    }
+    return hierarchy_ != NULL;
+}
+
+
+void SceneNode::ComputeTransforms(void){
+
+    glm::mat4 parent_transf = parent_ ? parent_->GetWorldTransform() : glm::mat4(1.0);
+    TransformHierarchy::ComputeTransforms(parent_transf, position_, orientation_, scale_, world_transf_, world_mat_, normal_mat_);
 }
 
 
-glm::mat4 SceneNode::SetupShader(GLuint program, glm::mat4 parent_transf){
+const BoundingSphere &SceneNode::GetBounds(void){
 
-    // Set attributes for shaders
-    GLint vertex_att = glGetAttribLocation(program, "vertex");
-    glVertexAttribPointer(vertex_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), 0);
-    glEnableVertexAttribArray(vertex_att);
+    if (bounds_dirty_){
+        UpdateBounds();
+    }
+    return bounds_;
+}
+
+
+BoundingSphere SceneNode::GetWorldBounds(void){
+
+    if (parent_){
+        return TransformSphere(GetBounds(), parent_->GetWorldTransform());
+    }
+    return GetBounds();
+}
+
+
+int SceneNode::GetNumDrawables(void){
+
+    if (bounds_dirty_){
+        UpdateBounds();
+    }
+    return num_drawables_;
+}
+
+
+bool SceneNode::IsDrawable(void) const {
 
-    GLint normal_att = glGetAttribLocation(program, "normal");
-    glVertexAttribPointer(normal_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (3*sizeof(GLfloat)));
-    glEnableVertexAttribArray(normal_att);
+    return (array_buffer_ > 0) && (material_ > 0);
+}
 
-    GLint color_att = glGetAttribLocation(program, "color");
-    glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (6*sizeof(GLfloat)));
-    glEnableVertexAttribArray(color_att);
 
-    GLint tex_att = glGetAttribLocation(program, "uv");
-    glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (9*sizeof(GLfloat)));
-    glEnableVertexAttribArray(tex_att);
+void SceneNode::InvalidateBounds(void){
 
-    // Bind texture if one is set
-    if (texture_ > 0) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_);
-        GLint texture_uniform = glGetUniformLocation(program, "texture_map");
-        if (texture_uniform >= 0) {
-            glUniform1i(texture_uniform, 0);
+    // Ancestors of a node with outdated bounds are always outdated too,
+    // so the walk can stop at the first one found
+    SceneNode *node = this;
+    while (node && !node->bounds_dirty_){
+        node->bounds_dirty_ = true;
+        node = node->parent_;
+    }
+}
+
+
+void SceneNode::UpdateBounds(void){
+
+    // Descendants come after their ancestors in the flattened hierarchy,
+    // so a walk of the subtree backwards updates every child before its
+    // parent, without one call per level of a deep chain
+    if (UpdateHierarchy()){
+        for (int i = hierarchy_->GetSubtreeEnd(index_) - 1; i >= index_; i--){
+            SceneNode *node = hierarchy_->GetNode(i);
+            if (node->bounds_dirty_){
+                node->ComputeBounds();
+            }
         }
+        return;
     }
 
-    // World transformation
-    glm::mat4 scaling = glm::scale(glm::mat4(1.0), scale_);
-    glm::mat4 rotation = glm::mat4_cast(orientation_);
-    glm::mat4 translation = glm::translate(glm::mat4(1.0), position_);
-    glm::mat4 transf = parent_transf * translation * rotation;
-    glm::mat4 local_transf = transf * scaling;
+    // Outside of a hierarchy, the children update their own bounds
+    ComputeBounds();
+}
+
 
-    GLint world_mat = glGetUniformLocation(program, "world_mat");
-    glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(local_transf));
+void SceneNode::ComputeBounds(void){
+
+    // Bounds in the frame of the node, without its scaling
+    BoundingSphere bounds = EmptySphere();
+    num_drawables_ = 0;
+    if (IsDrawable()){
+        glm::mat4 scaling = glm::scale(glm::mat4(1.0), scale_);
+        bounds = TransformSphere(geometry_->GetBoundingSphere(), scaling);
+        num_drawables_ = 1;
+    }
+    for (std::vector<SceneNode *>::const_iterator it = children_.begin(); it != children_.end(); it++){
+        bounds = MergeSpheres(bounds, (*it)->GetBounds());
+        num_drawables_ += (*it)->GetNumDrawables();
+    }
+
+    // Move the bounds to the frame of the parent
+    bounds_ = TransformSphere(bounds, GetLocalTransform());
+    bounds_dirty_ = false;
+}
 
-    glm::mat4 normal_matrix = glm::transpose(glm::inverse(transf));
-    GLint normal_mat = glGetUniformLocation(program, "normal_mat");
-    glUniformMatrix4fv(normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix));
 
-    // Timer
-    GLint timer_var = glGetUniformLocation(program, "timer");
-    double current_time = glfwGetTime();
-    glUniform1f(timer_var, (float) current_time);
+void SceneNode::Update(float /* delta_time */){
 
-    // Return transformation of node combined with parent, without scaling
-    return transf;
+    // Do nothing for this generic type of scene node
 }
 
 
@@ -254,10 +384,13 @@ void SceneNode::SetShader(Resource* material) {
         }
 
         material_ = material->GetResource();
+        program_ = material->GetMaterialProgram();
     }
     else {
         material_ = 0;
+        program_ = NULL;
     }
+    InvalidateBounds();
 }
 
 
@@ -274,13 +407,16 @@ void SceneNode::SetGeometry(Resource* geometry) {
             throw(std::invalid_argument(std::string("Invalid type of geometry")));
         }
 
+        geometry_ = geometry;
         array_buffer_ = geometry->GetArrayBuffer();
         element_array_buffer_ = geometry->GetElementArrayBuffer();
         size_ = geometry->GetSize();
     }
     else {
+        geometry_ = NULL;
         array_buffer_ = 0;
     }
+    InvalidateBounds();
 }
 
 
@@ -302,10 +438,50 @@ GLuint SceneNode::GetTexture(void) const {
 }
 
 
+const Resource *SceneNode::GetGeometry(void) const {
+
+    return geometry_;
+}
+
+
 void SceneNode::AddChild(SceneNode *node){
 
     children_.push_back(node);
     node->parent_ = this;
+    if (hierarchy_){
+        hierarchy_->InvalidateTopology();
+    }
+    InvalidateBounds();
+}
+
+
+void SceneNode::RemoveChild(SceneNode *node){
+
+    for (std::vector<SceneNode *>::iterator it = children_.begin(); it != children_.end(); it++){
+        if (*it == node){
+            children_.erase(it);
+            node->parent_ = NULL;
+            if (hierarchy_){
+                hierarchy_->InvalidateTopology();
+            }
+            InvalidateBounds();
+            return;
+        }
+    }
+}
+
+
+void SceneNode::SetHierarchy(TransformHierarchy *hierarchy, int index){
+
+    // A node leaving a hierarchy takes its state back; a node joining one
+    // already had its state copied by the hierarchy
+    if (hierarchy_){
+        position_ = hierarchy_->GetPosition(index_);
+        orientation_ = hierarchy_->GetOrientation(index_);
+        scale_ = hierarchy_->GetScale(index_);
+    }
+    hierarchy_ = hierarchy;
+    index_ = index;
 }
 
 
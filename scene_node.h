@@ -12,6 +12,9 @@
 
 #include "resource.h"
 #include "camera.h"
+#include "render_queue.h"
+#include "bounding_volume.h"
+#include "transform_hierarchy.h"
 
 namespace game {
 
@@ -22,8 +25,9 @@ namespace game {
             // Create scene node from given resources
             SceneNode(const std::string name, const Resource *geometry, const Resource *material);
 
-            // Destructor
-            ~SceneNode();
+            // Destructor, virtual since nodes of derived types are deleted
+            // through base pointers
+            virtual ~SceneNode();
             
             // Get name of node
             const std::string GetName(void) const;
@@ -37,18 +41,47 @@ namespace game {
             void SetPosition(glm::vec3 position);
             void SetOrientation(glm::quat orientation);
             void SetScale(glm::vec3 scale);
+            // Move the node without interpolating from its previous
+            // position, e.g. when it is respawned
+            void Teleport(glm::vec3 position);
             
             // Perform transformations on node
             void Translate(glm::vec3 trans);
             void Rotate(glm::quat rot);
             void Scale(glm::vec3 scale);
 
-            // Draw the node according to scene parameters in 'camera'
-            // variable
-            virtual glm::mat4 Draw(Camera *camera, glm::mat4 parent_transf);
-
-            // Update the node
-            virtual void Update(void);
+            // Draw the node by adding it to the render queue, unless its
+            // geometry is outside of the view volume
+            virtual void Draw(RenderQueue *queue, const Frustum &frustum);
+
+            // Transformations of the node
+            // Once the node is part of a scene, they are cached in the
+            // flattened hierarchy and only recomputed after the node or
+            // one of its ancestors moves
+            // Translation and rotation of the node relative to its parent
+            glm::mat4 GetLocalTransform(void) const;
+            // Local transformation combined with those of the ancestors,
+            // without scaling, as inherited by the children
+            const glm::mat4 &GetWorldTransform(void);
+            // World transformation including the scaling of the node
+            const glm::mat4 &GetWorldMatrix(void);
+            // Transformation for normals
+            const glm::mat4 &GetNormalMatrix(void);
+
+            // Sphere enclosing the geometry of the node and of all its
+            // descendants, in the coordinate frame of the parent
+            // Cached until the node or one of its descendants changes
+            const BoundingSphere &GetBounds(void);
+            // Bounds of the subtree in world coordinates
+            BoundingSphere GetWorldBounds(void);
+            // Number of nodes with something to draw in the subtree
+            int GetNumDrawables(void);
+            // Whether the node has geometry and a material
+            bool IsDrawable(void) const;
+
+            // Advance the node by one simulation step of the given length,
+            // in seconds
+            virtual void Update(float delta_time);
 
             // OpenGL variables
             GLenum GetMode(void) const;
@@ -63,37 +96,63 @@ namespace game {
             void SetGeometry(Resource* geometry);
             void SetTexture(Resource* texture);
             GLuint GetTexture(void) const;
+            const Resource *GetGeometry(void) const;
 
 
             // Hierarchy-related methods
             void AddChild(SceneNode *node);
+            void RemoveChild(SceneNode *node);
+            // Move the state of the node into a flattened hierarchy, at
+            // the given index, or back into the node when hierarchy is NULL
+            void SetHierarchy(TransformHierarchy *hierarchy, int index);
             std::vector<SceneNode *>::const_iterator children_begin() const;
             std::vector<SceneNode *>::const_iterator children_end() const;
 
         private:
             std::string name_; // Name of the scene node
+            const Resource *geometry_; // Geometry resource, which owns the vertex array objects
             GLuint array_buffer_; // References to geometry: vertex and array buffers
             GLuint element_array_buffer_;
             GLenum mode_; // Type of geometry
             GLsizei size_; // Number of primitives in geometry
             GLuint material_; // Reference to shader program
+            const MaterialProgram *program_; // Reflected interface of the shader program
             GLuint texture_; // Reference to texture
-            glm::vec3 position_; // Position of node
+            glm::vec3 position_; // Position of node, when not in a hierarchy
             glm::quat orientation_; // Orientation of node
             glm::vec3 scale_; // Scale of node
+            TransformHierarchy *hierarchy_; // Flattened hierarchy holding the state, or NULL
+            int index_; // Index of the node in the hierarchy
  
             bool shouldDraw_ = true;
 
+            // Transformations computed for a node outside of a hierarchy
+            glm::mat4 world_transf_;
+            glm::mat4 world_mat_;
+            glm::mat4 normal_mat_;
+
+            // Bring the hierarchy up to date, and return whether the node
+            // is still part of it
+            bool UpdateHierarchy(void);
+            // Compute the transformations of a node outside of a hierarchy
+            void ComputeTransforms(void);
+
+            // Bounds of the subtree
+            bool bounds_dirty_; // Bounds must be recomputed
+            BoundingSphere bounds_; // Bounds in the frame of the parent
+            int num_drawables_; // Drawable nodes in the subtree
+
+            // Mark the bounds of the node and its ancestors as outdated
+            void InvalidateBounds(void);
+            // Recompute the outdated bounds of the subtree
+            void UpdateBounds(void);
+            // Recompute the bounds from the geometry and the children
+            void ComputeBounds(void);
 
             // Hierarchy
             SceneNode *parent_;
             std::vector<SceneNode *> children_;
 
-            // Set matrices that transform the node in a shader program
-            // Return transformation of current node combined with
-            // parent transformation, without including scaling
-            glm::mat4 SetupShader(GLuint program, glm::mat4 parent_transf);
-
     }; // class SceneNode
 
 } // namespace game
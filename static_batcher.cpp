@@ -0,0 +1,133 @@
+#include <stdexcept>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "static_batcher.h"
+
+namespace game {
+
+// Number of floats per vertex in the interleaved vertex format
+const int batch_vertex_att_g = 11;
+
+
+StaticBatcher::StaticBatcher(ResourceManager *resman){
+
+    resman_ = resman;
+    merged_nodes_ = 0;
+}
+
+
+StaticBatcher::~StaticBatcher(){
+}
+
+
+int StaticBatcher::Bake(SceneNode *node, const std::string mesh_name){
+
+    // Nothing to merge into a node that is not drawn, or without children
+    if (!node->IsDrawable() || (node->GetMode() != GL_TRIANGLES) || (node->children_begin() == node->children_end())){
+        return 0;
+    }
+    for (std::vector<SceneNode *>::const_iterator it = node->children_begin(); it != node->children_end(); it++){
+        if (!CanMerge(*it, node->GetMaterial(), node->GetTexture())){
+            return 0;
+        }
+    }
+
+    // The scaling of the node is baked into its own vertices only, since
+    // it does not apply to the children
+    vertex_.clear();
+    index_.clear();
+    glm::mat4 scaling = glm::scale(glm::mat4(1.0), node->GetScale());
+    Append(node, scaling, glm::mat4(1.0));
+    AppendChildren(node, glm::mat4(1.0), glm::mat4(1.0));
+
+    MeshHandle handle = resman_->AddMesh(mesh_name, &vertex_[0], vertex_.size() / batch_vertex_att_g, &index_[0], index_.size());
+    Resource *mesh = resman_->GetResource(handle);
+
+    // Detach the children, which are now part of the mesh of the node
+    std::vector<SceneNode *> children(node->children_begin(), node->children_end());
+    int merged = 0;
+    for (int i = 0; i < children.size(); i++){
+        merged += children[i]->GetNumDrawables();
+        node->RemoveChild(children[i]);
+    }
+    node->SetGeometry(mesh);
+    node->SetScale(glm::vec3(1.0, 1.0, 1.0));
+
+    merged_nodes_ += merged;
+    return merged;
+}
+
+
+int StaticBatcher::GetMergedNodes(void) const {
+
+    return merged_nodes_;
+}
+
+
+bool StaticBatcher::CanMerge(const SceneNode *node, GLuint material, GLuint texture){
+
+    // Nodes without geometry only contribute their transformation
+    if (node->IsDrawable()){
+        if ((node->GetMode() != GL_TRIANGLES) || (node->GetMaterial() != material) || (node->GetTexture() != texture)){
+            return false;
+        }
+    }
+    for (std::vector<SceneNode *>::const_iterator it = node->children_begin(); it != node->children_end(); it++){
+        if (!CanMerge(*it, material, texture)){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void StaticBatcher::Append(const SceneNode *node, const glm::mat4 &transf, const glm::mat4 &rotation){
+
+    if (!node->IsDrawable()){
+        return;
+    }
+
+    std::vector<GLfloat> vertex;
+    std::vector<GLuint> index;
+    node->GetGeometry()->ReadMesh(vertex, index);
+
+    // Indices continue after the vertices already in the mesh
+    GLuint first = vertex_.size() / batch_vertex_att_g;
+    for (int i = 0; i < index.size(); i++){
+        index_.push_back(index[i] + first);
+    }
+
+    // Transform positions and normals; color and texture coordinates are
+    // copied unchanged
+    for (int i = 0; i < vertex.size(); i += batch_vertex_att_g){
+        glm::vec3 position = glm::vec3(transf * glm::vec4(vertex[i], vertex[i + 1], vertex[i + 2], 1.0));
+        glm::vec3 normal = glm::vec3(rotation * glm::vec4(vertex[i + 3], vertex[i + 4], vertex[i + 5], 0.0));
+        for (int k = 0; k < 3; k++){
+            vertex_.push_back(position[k]);
+        }
+        for (int k = 0; k < 3; k++){
+            vertex_.push_back(normal[k]);
+        }
+        for (int k = 6; k < batch_vertex_att_g; k++){
+            vertex_.push_back(vertex[i + k]);
+        }
+    }
+}
+
+
+void StaticBatcher::AppendChildren(const SceneNode *node, const glm::mat4 &transf, const glm::mat4 &rotation){
+
+    // Same transformations as SceneNode::Draw, relative to the baked node
+    for (std::vector<SceneNode *>::const_iterator it = node->children_begin(); it != node->children_end(); it++){
+        const SceneNode *child = *it;
+        glm::mat4 child_rotation = rotation * glm::mat4_cast(child->GetOrientation());
+        glm::mat4 child_transf = transf * glm::translate(glm::mat4(1.0), child->GetPosition()) * glm::mat4_cast(child->GetOrientation());
+        glm::mat4 scaling = glm::scale(glm::mat4(1.0), child->GetScale());
+
+        Append(child, child_transf * scaling, child_rotation);
+        AppendChildren(child, child_transf, child_rotation);
+    }
+}
+
+} // namespace game
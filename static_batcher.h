@@ -0,0 +1,60 @@
+#ifndef STATIC_BATCHER_H_
+#define STATIC_BATCHER_H_
+
+#include <string>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "resource_manager.h"
+#include "scene_node.h"
+
+namespace game {
+
+    // Bakes static hierarchies into single meshes at load time
+    // A node and its descendants are merged into one mesh expressed in
+    // the frame of the node, so the whole hierarchy costs one draw and
+    // can still be moved as a whole by changing the node
+    class StaticBatcher {
+
+        public:
+            StaticBatcher(ResourceManager *resman);
+            ~StaticBatcher();
+
+            // Merge the geometry of the children of a node into the node
+            // itself, and detach the merged children from the hierarchy
+            // The merged mesh is added to the resource manager under the
+            // given name
+            // The subtree is only merged if all its nodes share the
+            // material and texture of the node; return the number of
+            // nodes that were merged into it
+            int Bake(SceneNode *node, const std::string mesh_name);
+
+            // Nodes merged by all calls to Bake
+            int GetMergedNodes(void) const;
+
+        private:
+            ResourceManager *resman_; // Owner of the merged meshes
+            int merged_nodes_;
+
+            // Interleaved vertices and indices of the mesh being built
+            std::vector<GLfloat> vertex_;
+            std::vector<GLuint> index_;
+
+            // Whether a node and all its descendants can be drawn with
+            // the given material and texture
+            static bool CanMerge(const SceneNode *node, GLuint material, GLuint texture);
+            // Append the geometry of a node to the mesh, transformed by
+            // the given matrix; normals only follow the rotation
+            void Append(const SceneNode *node, const glm::mat4 &transf, const glm::mat4 &rotation);
+            // Append the geometry of the descendants of a node, given the
+            // transformation of the node without its scaling
+            void AppendChildren(const SceneNode *node, const glm::mat4 &transf, const glm::mat4 &rotation);
+
+    }; // class StaticBatcher
+
+} // namespace game
+
+#endif // STATIC_BATCHER_H_
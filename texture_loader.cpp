@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <sstream>
+#include <SOIL/SOIL.h>
+
+#include "texture_loader.h"
+#include "profiler.h"
+
+namespace game {
+
+TextureLoader::TextureLoader(void){
+
+    pending_ = 0;
+    stop_ = false;
+}
+
+
+TextureLoader::~TextureLoader(){
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        todo_.clear();
+    }
+    queued_.notify_all();
+    for (int i = 0; i < worker_.size(); i++){
+        worker_[i].join();
+    }
+    for (int i = 0; i < done_.size(); i++){
+        if (done_[i].data){
+            SOIL_free_image_data(done_[i].data);
+        }
+    }
+}
+
+
+void TextureLoader::Queue(int index, const std::string &filename){
+
+    Image image;
+    image.index = index;
+    image.filename = filename;
+    image.data = NULL;
+    image.width = 0;
+    image.height = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    todo_.push_back(image);
+    pending_++;
+
+    // One more worker while some files wait and hardware threads are free
+    int workers = worker_.size();
+    int max_workers = std::max((int) std::thread::hardware_concurrency(), 1);
+    if ((workers < todo_.size()) && (workers < max_workers)){
+        worker_.push_back(std::thread(&TextureLoader::Work, this, workers + 1));
+    }
+    queued_.notify_one();
+}
+
+
+bool TextureLoader::Take(Image &image, bool wait){
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait){
+        decoded_.wait(lock, [this](){ return (done_.size() > 0) || (pending_ == 0); });
+    }
+    if (done_.size() == 0){
+        return false;
+    }
+    image = done_.front();
+    done_.pop_front();
+    pending_--;
+    return true;
+}
+
+
+int TextureLoader::GetPending(void) const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+
+void TextureLoader::Work(int number){
+
+    std::ostringstream name;
+    name << "Texture loader " << number;
+    Profiler::SetThreadName(name.str());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true){
+        queued_.wait(lock, [this](){ return (todo_.size() > 0) || stop_; });
+        if (stop_){
+            return;
+        }
+        Image image = todo_.front();
+        todo_.pop_front();
+
+        // Decode without holding the lock
+        // SOIL keeps the reason of its last failure in a global, so the
+        // reason given for a file may come from another one that failed
+        // at the same time
+        lock.unlock();
+        {
+            PROFILE_ZONE("Decode texture");
+            image.data = SOIL_load_image(image.filename.c_str(), &image.width, &image.height, 0, SOIL_LOAD_RGBA);
+            if (!image.data){
+                image.error = SOIL_last_result();
+            }
+        }
+        lock.lock();
+
+        done_.push_back(image);
+        decoded_.notify_all();
+    }
+}
+
+} // namespace game
@@ -0,0 +1,60 @@
+#ifndef TEXTURE_LOADER_H_
+#define TEXTURE_LOADER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace game {
+
+    // Decoding of image files on a pool of worker threads
+    // Decoded images are handed back to the thread that queued them,
+    // which uploads them, since only it has the OpenGL context
+    class TextureLoader {
+
+        public:
+            // Image decoded from a file, or the error that prevented it
+            struct Image {
+                int index; // Position of the texture in its resource manager
+                std::string filename;
+                unsigned char *data; // RGBA pixels, or NULL on error
+                int width;
+                int height;
+                std::string error;
+            };
+
+            TextureLoader(void);
+            // Waits for the workers, and frees images never taken
+            ~TextureLoader();
+
+            // Add a file to decode; workers are started as needed, up to
+            // one per hardware thread
+            void Queue(int index, const std::string &filename);
+            // Take a decoded image; without waiting, return false if none
+            // is ready yet
+            // Free the pixels of the images taken with SOIL_free_image_data()
+            bool Take(Image &image, bool wait);
+            // Number of images queued and not taken yet
+            int GetPending(void) const;
+
+        private:
+            std::vector<std::thread> worker_;
+            mutable std::mutex mutex_;
+            std::condition_variable queued_; // Signals new files and shutdown
+            std::condition_variable decoded_; // Signals decoded images
+            std::deque<Image> todo_; // Files to decode
+            std::deque<Image> done_; // Images decoded, not taken yet
+            int pending_;
+            bool stop_;
+
+            // Loop of a worker thread
+            void Work(int number);
+
+    }; // class TextureLoader
+
+} // namespace game
+
+#endif // TEXTURE_LOADER_H_
@@ -0,0 +1,305 @@
+#include <utility>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "transform_hierarchy.h"
+#include "scene_node.h"
+#include "transform_kernel.h"
+
+namespace game {
+
+TransformHierarchy::TransformHierarchy(void){
+
+    root_ = NULL;
+    topology_dirty_ = false;
+    transform_dirty_ = false;
+    blend_ = 1.0;
+}
+
+
+TransformHierarchy::~TransformHierarchy(){
+
+    Clear();
+}
+
+
+void TransformHierarchy::Build(SceneNode *root){
+
+    Clear();
+    root_ = root;
+    topology_dirty_ = false;
+    transform_dirty_ = true;
+    if (!root){
+        return;
+    }
+
+    // Depth-first traversal; children are pushed in reverse so that they
+    // keep their order in the arrays
+    std::vector<std::pair<SceneNode *, int> > stck;
+    stck.push_back(std::make_pair(root, -1));
+    while (stck.size() > 0){
+        SceneNode *node = stck.back().first;
+        int parent = stck.back().second;
+        stck.pop_back();
+
+        int index = node_.size();
+        node_.push_back(node);
+        parent_.push_back(parent);
+        subtree_end_.push_back(index + 1);
+        position_.push_back(node->GetPosition());
+        orientation_.push_back(node->GetOrientation());
+        scale_.push_back(node->GetScale());
+        changed_.push_back(1);
+        previous_position_.push_back(node->GetPosition());
+        previous_orientation_.push_back(node->GetOrientation());
+        moved_.push_back(0);
+        node->SetHierarchy(this, index);
+
+        std::vector<SceneNode *> children(node->children_begin(), node->children_end());
+        for (int i = children.size() - 1; i >= 0; i--){
+            stck.push_back(std::make_pair(children[i], index));
+        }
+    }
+
+    // Each subtree ends where the last of its descendants' subtrees ends
+    for (int i = node_.size() - 1; i > 0; i--){
+        if (subtree_end_[parent_[i]] < subtree_end_[i]){
+            subtree_end_[parent_[i]] = subtree_end_[i];
+        }
+    }
+
+    blend_position_.resize(node_.size());
+    blend_orientation_.resize(node_.size());
+    world_transf_.resize(node_.size());
+    world_mat_.resize(node_.size());
+    normal_mat_.resize(node_.size());
+}
+
+
+void TransformHierarchy::InvalidateTopology(void){
+
+    topology_dirty_ = true;
+}
+
+
+void TransformHierarchy::Update(void){
+
+    if (topology_dirty_){
+        Build(root_);
+    }
+    if (!transform_dirty_){
+        return;
+    }
+
+    // Parents come first, so a change reaches all descendants in the
+    // same pass
+    int size = node_.size();
+    for (int i = 0; i < size; i++){
+        if (i > 0){
+            changed_[i] |= changed_[parent_[i]];
+        }
+        if (!changed_[i]){
+            continue;
+        }
+        // State drawn between the last two steps
+        blend_position_[i] = position_[i];
+        blend_orientation_[i] = orientation_[i];
+        if (moved_[i]){
+            if (previous_position_[i] != position_[i]){
+                blend_position_[i] = glm::mix(previous_position_[i], position_[i], blend_);
+            }
+            if (previous_orientation_[i] != orientation_[i]){
+                blend_orientation_[i] = glm::slerp(previous_orientation_[i], orientation_[i], blend_);
+            }
+        }
+    }
+
+    // Recompute each run of changed nodes with the batch kernel
+    int i = 0;
+    while (i < size){
+        if (!changed_[i]){
+            i++;
+            continue;
+        }
+        int end = i + 1;
+        while ((end < size) && changed_[end]){
+            end++;
+        }
+        TransformKernel::Compose(i, end - i, &parent_[0], &blend_position_[0], &blend_orientation_[0], &scale_[0],
+                                 &world_transf_[0], &world_mat_[0], &normal_mat_[0]);
+        i = end;
+    }
+    changed_.assign(size, 0);
+    transform_dirty_ = false;
+}
+
+
+void TransformHierarchy::BeginStep(void){
+
+    // Nodes that moved in the last step were drawn interpolated, and
+    // must now be drawn at their current state
+    for (int i = 0; i < node_.size(); i++){
+        if (moved_[i]){
+            previous_position_[i] = position_[i];
+            previous_orientation_[i] = orientation_[i];
+            changed_[i] = 1;
+            moved_[i] = 0;
+            transform_dirty_ = true;
+        }
+    }
+}
+
+
+void TransformHierarchy::SetBlend(float blend){
+
+    if (blend == blend_){
+        return;
+    }
+    blend_ = blend;
+    for (int i = 0; i < node_.size(); i++){
+        if (moved_[i]){
+            changed_[i] = 1;
+            transform_dirty_ = true;
+        }
+    }
+}
+
+
+void TransformHierarchy::ResetMotion(int index){
+
+    previous_position_[index] = position_[index];
+    previous_orientation_[index] = orientation_[index];
+}
+
+
+int TransformHierarchy::GetSize(void) const {
+
+    return node_.size();
+}
+
+
+SceneNode *TransformHierarchy::GetNode(int index) const {
+
+    return node_[index];
+}
+
+
+int TransformHierarchy::GetParent(int index) const {
+
+    return parent_[index];
+}
+
+
+int TransformHierarchy::GetSubtreeEnd(int index) const {
+
+    return subtree_end_[index];
+}
+
+
+const glm::vec3 &TransformHierarchy::GetPosition(int index) const {
+
+    return position_[index];
+}
+
+
+const glm::quat &TransformHierarchy::GetOrientation(int index) const {
+
+    return orientation_[index];
+}
+
+
+const glm::vec3 &TransformHierarchy::GetScale(int index) const {
+
+    return scale_[index];
+}
+
+
+void TransformHierarchy::SetPosition(int index, const glm::vec3 &position){
+
+    position_[index] = position;
+    changed_[index] = 1;
+    moved_[index] = 1;
+    transform_dirty_ = true;
+}
+
+
+void TransformHierarchy::SetOrientation(int index, const glm::quat &orientation){
+
+    orientation_[index] = orientation;
+    changed_[index] = 1;
+    moved_[index] = 1;
+    transform_dirty_ = true;
+}
+
+
+void TransformHierarchy::SetScale(int index, const glm::vec3 &scale){
+
+    scale_[index] = scale;
+    changed_[index] = 1;
+    transform_dirty_ = true;
+}
+
+
+const glm::mat4 &TransformHierarchy::GetWorldTransform(int index) const {
+
+    return world_transf_[index];
+}
+
+
+const glm::mat4 &TransformHierarchy::GetWorldMatrix(int index) const {
+
+    return world_mat_[index];
+}
+
+
+const glm::mat4 &TransformHierarchy::GetNormalMatrix(int index) const {
+
+    return normal_mat_[index];
+}
+
+
+void TransformHierarchy::ComputeTransforms(const glm::mat4 &parent_transf, const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale,
+                                           glm::mat4 &world_transf, glm::mat4 &world_mat, glm::mat4 &normal_mat){
+
+    glm::mat4 rotation = glm::mat4_cast(orientation);
+    glm::mat4 translation = glm::translate(glm::mat4(1.0), position);
+    world_transf = parent_transf * translation * rotation;
+    world_mat = glm::scale(world_transf, scale);
+
+    // Scaling is not inherited, so the world transformation is a rotation
+    // R followed by a translation t; its inverse is R^T followed by -R^T t,
+    // and the transpose of that keeps R and moves -R^T t to the last row
+    // Note that in glm, the reference for matrix entries is of the form
+    // matrix[column][row]
+    glm::vec3 t = glm::vec3(world_transf[3]);
+    normal_mat = world_transf;
+    for (int i = 0; i < 3; i++){
+        normal_mat[i][3] = -glm::dot(glm::vec3(world_transf[i]), t);
+    }
+    normal_mat[3] = glm::vec4(0.0, 0.0, 0.0, 1.0);
+}
+
+
+void TransformHierarchy::Clear(void){
+
+    for (int i = 0; i < node_.size(); i++){
+        node_[i]->SetHierarchy(NULL, -1);
+    }
+    node_.clear();
+    parent_.clear();
+    subtree_end_.clear();
+    position_.clear();
+    orientation_.clear();
+    scale_.clear();
+    changed_.clear();
+    previous_position_.clear();
+    previous_orientation_.clear();
+    moved_.clear();
+    blend_position_.clear();
+    blend_orientation_.clear();
+    world_transf_.clear();
+    world_mat_.clear();
+    normal_mat_.clear();
+}
+
+} // namespace game
@@ -0,0 +1,105 @@
+#ifndef TRANSFORM_HIERARCHY_H_
+#define TRANSFORM_HIERARCHY_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+namespace game {
+
+    class SceneNode;
+
+    // Flattened copy of a scene hierarchy
+    // The transformation state of all nodes is kept in parallel arrays in
+    // depth-first order, so that parents always come before their
+    // children and each subtree is a contiguous range; the scene nodes
+    // read and write their state through their index in the arrays
+    class TransformHierarchy {
+
+        public:
+            TransformHierarchy(void);
+            ~TransformHierarchy();
+
+            // Flatten the hierarchy under a root; nodes of the previous
+            // hierarchy get their state back first
+            void Build(SceneNode *root);
+            // Flatten the hierarchy again before the next update, after
+            // nodes were added or removed
+            void InvalidateTopology(void);
+            // Rebuild the arrays if needed, then recompute the outdated
+            // world transformations in a single pass
+            void Update(void);
+
+            // Interpolation between simulation steps
+            // Keep the current local state as the state of the previous step
+            void BeginStep(void);
+            // Blend factor between the previous (0) and the current (1)
+            // state used by the world transformations
+            void SetBlend(float blend);
+            // Do not interpolate a node from its previous state, e.g. after
+            // it jumped to a new position
+            void ResetMotion(int index);
+
+            // Nodes in depth-first order
+            int GetSize(void) const;
+            SceneNode *GetNode(int index) const;
+            // Index of the parent of a node, or -1 for the root
+            int GetParent(int index) const;
+            // Index right after the last descendant of a node
+            int GetSubtreeEnd(int index) const;
+
+            // Local state of a node, relative to its parent
+            const glm::vec3 &GetPosition(int index) const;
+            const glm::quat &GetOrientation(int index) const;
+            const glm::vec3 &GetScale(int index) const;
+            void SetPosition(int index, const glm::vec3 &position);
+            void SetOrientation(int index, const glm::quat &orientation);
+            void SetScale(int index, const glm::vec3 &scale);
+
+            // World transformations of a node, valid after Update(), with
+            // position and orientation interpolated between the last two
+            // simulation steps
+            // Transformation without scaling, as inherited by the children
+            const glm::mat4 &GetWorldTransform(int index) const;
+            // Transformation including the scaling of the node
+            const glm::mat4 &GetWorldMatrix(int index) const;
+            // Transformation for normals
+            const glm::mat4 &GetNormalMatrix(int index) const;
+
+            // Compute the world transformations of a node from the world
+            // transformation of its parent and its local state
+            static void ComputeTransforms(const glm::mat4 &parent_transf, const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale,
+                                          glm::mat4 &world_transf, glm::mat4 &world_mat, glm::mat4 &normal_mat);
+
+        private:
+            SceneNode *root_; // Root of the flattened hierarchy
+            bool topology_dirty_; // Nodes were added or removed
+            bool transform_dirty_; // Some local state changed
+            float blend_; // Interpolation factor between the last two steps
+
+            // State of the nodes, indexed in depth-first order
+            std::vector<SceneNode *> node_;
+            std::vector<int> parent_;
+            std::vector<int> subtree_end_;
+            std::vector<glm::vec3> position_;
+            std::vector<glm::quat> orientation_;
+            std::vector<glm::vec3> scale_;
+            std::vector<char> changed_; // Local state changed since the last update
+            std::vector<glm::vec3> previous_position_; // State of the previous step
+            std::vector<glm::quat> previous_orientation_;
+            std::vector<char> moved_; // Moved during the current step
+            std::vector<glm::vec3> blend_position_; // Interpolated state
+            std::vector<glm::quat> blend_orientation_;
+            std::vector<glm::mat4> world_transf_;
+            std::vector<glm::mat4> world_mat_;
+            std::vector<glm::mat4> normal_mat_;
+
+            // Give the nodes their state back and empty the arrays
+            void Clear(void);
+
+    }; // class TransformHierarchy
+
+} // namespace game
+
+#endif // TRANSFORM_HIERARCHY_H_
@@ -0,0 +1,473 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+#include "transform_kernel.h"
+#include "transform_hierarchy.h"
+
+// SIMD versions are only built for x86 processors; elsewhere, the scalar
+// version is always used
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSFORM_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Functions using an instruction set that the rest of the program is
+// not compiled for must say so with GCC and Clang
+// Helpers shared by both versions are inlined, so that they use the
+// encoding of the caller and avoid transitions between SSE and AVX
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define KERNEL_INLINE __forceinline
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define KERNEL_INLINE inline
+#endif
+
+namespace game {
+
+// Largest relative difference from the reference accepted by the self-test
+const float kernel_tolerance_g = 1e-5;
+// Number of random nodes used by the self-test; not a multiple of the
+// batch sizes, so that the remainders are tested too
+const int kernel_test_nodes_g = 61;
+
+TransformKernel::Path TransformKernel::path_ = TransformKernel::Scalar;
+bool TransformKernel::selected_ = false;
+
+
+#ifdef TRANSFORM_KERNEL_X86
+
+// Local transformation of one node, i.e. the rotation matrix of its
+// orientation with its position as the last column, computed as in glm
+static KERNEL_INLINE void LocalScalar(int i, const glm::vec3 *position, const glm::quat *orientation, glm::mat4 *local){
+
+    local[i] = glm::mat4_cast(orientation[i]);
+    local[i][3] = glm::vec4(position[i], 1.0);
+}
+
+
+// Turn the local transformation stored in world_transf[i] into the world
+// transformations of the node
+// The products and sums are done in the same order as glm, so the results
+// are identical to the reference
+TARGET_SSE2 static KERNEL_INLINE void FinishNodeSSE(int i, const int *parent, const glm::vec3 *scale,
+                                                    glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    float *w = &world_transf[i][0][0];
+    __m128 col[4];
+    for (int c = 0; c < 4; c++){
+        col[c] = _mm_loadu_ps(w + 4*c);
+    }
+
+    // Combine with the world transformation of the parent
+    if (parent[i] >= 0){
+        const float *p = &world_transf[parent[i]][0][0];
+        __m128 p0 = _mm_loadu_ps(p);
+        __m128 p1 = _mm_loadu_ps(p + 4);
+        __m128 p2 = _mm_loadu_ps(p + 8);
+        __m128 p3 = _mm_loadu_ps(p + 12);
+        for (int c = 0; c < 4; c++){
+            __m128 l = col[c];
+            __m128 sum = _mm_mul_ps(p0, _mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p1, _mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p2, _mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(p3, _mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3))));
+            col[c] = sum;
+        }
+    }
+
+    // Scaled world matrix
+    float *m = &world_mat[i][0][0];
+    for (int c = 0; c < 3; c++){
+        _mm_storeu_ps(w + 4*c, col[c]);
+        _mm_storeu_ps(m + 4*c, _mm_mul_ps(col[c], _mm_set1_ps(scale[i][c])));
+    }
+    _mm_storeu_ps(w + 12, col[3]);
+    _mm_storeu_ps(m + 12, col[3]);
+
+    // Normal matrix, as in TransformHierarchy::ComputeTransforms
+    float *n = &normal_mat[i][0][0];
+    for (int c = 0; c < 3; c++){
+        _mm_storeu_ps(n + 4*c, col[c]);
+        n[4*c + 3] = -(w[4*c]*w[12] + w[4*c + 1]*w[13] + w[4*c + 2]*w[14]);
+    }
+    _mm_storeu_ps(n + 12, _mm_set_ps(1.0, 0.0, 0.0, 0.0));
+}
+
+
+// Same as FinishNodeSSE, with two columns per operation
+TARGET_AVX2 static KERNEL_INLINE void FinishNodeAVX2(int i, const int *parent, const glm::vec3 *scale,
+                                                    glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    float *w = &world_transf[i][0][0];
+    __m256 col01 = _mm256_loadu_ps(w);
+    __m256 col23 = _mm256_loadu_ps(w + 8);
+
+    if (parent[i] >= 0){
+        const float *p = &world_transf[parent[i]][0][0];
+        __m256 p0 = _mm256_broadcast_ps((const __m128 *) p);
+        __m256 p1 = _mm256_broadcast_ps((const __m128 *) (p + 4));
+        __m256 p2 = _mm256_broadcast_ps((const __m128 *) (p + 8));
+        __m256 p3 = _mm256_broadcast_ps((const __m128 *) (p + 12));
+        __m256 sum01 = _mm256_mul_ps(p0, _mm256_permute_ps(col01, _MM_SHUFFLE(0, 0, 0, 0)));
+        __m256 sum23 = _mm256_mul_ps(p0, _mm256_permute_ps(col23, _MM_SHUFFLE(0, 0, 0, 0)));
+        sum01 = _mm256_add_ps(sum01, _mm256_mul_ps(p1, _mm256_permute_ps(col01, _MM_SHUFFLE(1, 1, 1, 1))));
+        sum23 = _mm256_add_ps(sum23, _mm256_mul_ps(p1, _mm256_permute_ps(col23, _MM_SHUFFLE(1, 1, 1, 1))));
+        sum01 = _mm256_add_ps(sum01, _mm256_mul_ps(p2, _mm256_permute_ps(col01, _MM_SHUFFLE(2, 2, 2, 2))));
+        sum23 = _mm256_add_ps(sum23, _mm256_mul_ps(p2, _mm256_permute_ps(col23, _MM_SHUFFLE(2, 2, 2, 2))));
+        sum01 = _mm256_add_ps(sum01, _mm256_mul_ps(p3, _mm256_permute_ps(col01, _MM_SHUFFLE(3, 3, 3, 3))));
+        sum23 = _mm256_add_ps(sum23, _mm256_mul_ps(p3, _mm256_permute_ps(col23, _MM_SHUFFLE(3, 3, 3, 3))));
+        col01 = sum01;
+        col23 = sum23;
+    }
+    _mm256_storeu_ps(w, col01);
+    _mm256_storeu_ps(w + 8, col23);
+
+    // Scaled world matrix; the last column is not scaled
+    float *m = &world_mat[i][0][0];
+    _mm256_storeu_ps(m, _mm256_mul_ps(col01, _mm256_set_m128(_mm_set1_ps(scale[i][1]), _mm_set1_ps(scale[i][0]))));
+    _mm256_storeu_ps(m + 8, _mm256_mul_ps(col23, _mm256_set_m128(_mm_set1_ps(1.0), _mm_set1_ps(scale[i][2]))));
+
+    float *n = &normal_mat[i][0][0];
+    _mm256_storeu_ps(n, col01);
+    _mm_storeu_ps(n + 8, _mm256_castps256_ps128(col23));
+    for (int c = 0; c < 3; c++){
+        n[4*c + 3] = -(w[4*c]*w[12] + w[4*c + 1]*w[13] + w[4*c + 2]*w[14]);
+    }
+    _mm_storeu_ps(n + 12, _mm_set_ps(1.0, 0.0, 0.0, 0.0));
+}
+
+
+// Store the columns of the local transformations of four nodes, given
+// each entry of the columns for the four nodes
+TARGET_SSE2 static KERNEL_INLINE void StoreLocalSSE(int i, __m128 r[12], glm::mat4 *world_transf){
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0);
+    for (int c = 0; c < 4; c++){
+        // Transposing the entries gives the column of each node
+        __m128 x = r[3*c], y = r[3*c + 1], z = r[3*c + 2], w = (c < 3) ? zero : one;
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&world_transf[i][c][0], x);
+        _mm_storeu_ps(&world_transf[i + 1][c][0], y);
+        _mm_storeu_ps(&world_transf[i + 2][c][0], z);
+        _mm_storeu_ps(&world_transf[i + 3][c][0], w);
+    }
+}
+
+
+TARGET_SSE2 static void ComposeBlocksSSE(int first, int count, const int *parent,
+                                         const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                         glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    __m128 one = _mm_set1_ps(1.0);
+    __m128 two = _mm_set1_ps(2.0);
+    int end = first + count;
+    int i = first;
+
+    // Four nodes per iteration: rotation matrices are computed for all
+    // four at once, then each node is combined with its parent in order
+    for (; i + 4 <= end; i += 4){
+        const glm::quat *q = orientation + i;
+        const glm::vec3 *p = position + i;
+        __m128 qx = _mm_set_ps(q[3].x, q[2].x, q[1].x, q[0].x);
+        __m128 qy = _mm_set_ps(q[3].y, q[2].y, q[1].y, q[0].y);
+        __m128 qz = _mm_set_ps(q[3].z, q[2].z, q[1].z, q[0].z);
+        __m128 qw = _mm_set_ps(q[3].w, q[2].w, q[1].w, q[0].w);
+
+        __m128 qxx = _mm_mul_ps(qx, qx);
+        __m128 qyy = _mm_mul_ps(qy, qy);
+        __m128 qzz = _mm_mul_ps(qz, qz);
+        __m128 qxz = _mm_mul_ps(qx, qz);
+        __m128 qxy = _mm_mul_ps(qx, qy);
+        __m128 qyz = _mm_mul_ps(qy, qz);
+        __m128 qwx = _mm_mul_ps(qw, qx);
+        __m128 qwy = _mm_mul_ps(qw, qy);
+        __m128 qwz = _mm_mul_ps(qw, qz);
+
+        // Entries of the columns, as in glm::mat4_cast
+        __m128 r[12];
+        r[0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qyy, qzz)));
+        r[1] = _mm_mul_ps(two, _mm_add_ps(qxy, qwz));
+        r[2] = _mm_mul_ps(two, _mm_sub_ps(qxz, qwy));
+        r[3] = _mm_mul_ps(two, _mm_sub_ps(qxy, qwz));
+        r[4] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qzz)));
+        r[5] = _mm_mul_ps(two, _mm_add_ps(qyz, qwx));
+        r[6] = _mm_mul_ps(two, _mm_add_ps(qxz, qwy));
+        r[7] = _mm_mul_ps(two, _mm_sub_ps(qyz, qwx));
+        r[8] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qyy)));
+        r[9] = _mm_set_ps(p[3].x, p[2].x, p[1].x, p[0].x);
+        r[10] = _mm_set_ps(p[3].y, p[2].y, p[1].y, p[0].y);
+        r[11] = _mm_set_ps(p[3].z, p[2].z, p[1].z, p[0].z);
+        StoreLocalSSE(i, r, world_transf);
+
+        for (int k = i; k < i + 4; k++){
+            FinishNodeSSE(k, parent, scale, world_transf, world_mat, normal_mat);
+        }
+    }
+
+    // Remaining nodes one at a time
+    for (; i < end; i++){
+        LocalScalar(i, position, orientation, world_transf);
+        FinishNodeSSE(i, parent, scale, world_transf, world_mat, normal_mat);
+    }
+}
+
+
+TARGET_AVX2 static void ComposeBlocksAVX2(int first, int count, const int *parent,
+                                          const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                          glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    __m256 one = _mm256_set1_ps(1.0);
+    __m256 two = _mm256_set1_ps(2.0);
+    int end = first + count;
+    int i = first;
+
+    // Eight nodes per iteration; the products are not fused, so that the
+    // results stay identical to the reference
+    for (; i + 8 <= end; i += 8){
+        const glm::quat *q = orientation + i;
+        const glm::vec3 *p = position + i;
+        __m256 qx = _mm256_set_ps(q[7].x, q[6].x, q[5].x, q[4].x, q[3].x, q[2].x, q[1].x, q[0].x);
+        __m256 qy = _mm256_set_ps(q[7].y, q[6].y, q[5].y, q[4].y, q[3].y, q[2].y, q[1].y, q[0].y);
+        __m256 qz = _mm256_set_ps(q[7].z, q[6].z, q[5].z, q[4].z, q[3].z, q[2].z, q[1].z, q[0].z);
+        __m256 qw = _mm256_set_ps(q[7].w, q[6].w, q[5].w, q[4].w, q[3].w, q[2].w, q[1].w, q[0].w);
+
+        __m256 qxx = _mm256_mul_ps(qx, qx);
+        __m256 qyy = _mm256_mul_ps(qy, qy);
+        __m256 qzz = _mm256_mul_ps(qz, qz);
+        __m256 qxz = _mm256_mul_ps(qx, qz);
+        __m256 qxy = _mm256_mul_ps(qx, qy);
+        __m256 qyz = _mm256_mul_ps(qy, qz);
+        __m256 qwx = _mm256_mul_ps(qw, qx);
+        __m256 qwy = _mm256_mul_ps(qw, qy);
+        __m256 qwz = _mm256_mul_ps(qw, qz);
+
+        __m256 r[12];
+        r[0] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qyy, qzz)));
+        r[1] = _mm256_mul_ps(two, _mm256_add_ps(qxy, qwz));
+        r[2] = _mm256_mul_ps(two, _mm256_sub_ps(qxz, qwy));
+        r[3] = _mm256_mul_ps(two, _mm256_sub_ps(qxy, qwz));
+        r[4] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qzz)));
+        r[5] = _mm256_mul_ps(two, _mm256_add_ps(qyz, qwx));
+        r[6] = _mm256_mul_ps(two, _mm256_add_ps(qxz, qwy));
+        r[7] = _mm256_mul_ps(two, _mm256_sub_ps(qyz, qwx));
+        r[8] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qyy)));
+        r[9] = _mm256_set_ps(p[7].x, p[6].x, p[5].x, p[4].x, p[3].x, p[2].x, p[1].x, p[0].x);
+        r[10] = _mm256_set_ps(p[7].y, p[6].y, p[5].y, p[4].y, p[3].y, p[2].y, p[1].y, p[0].y);
+        r[11] = _mm256_set_ps(p[7].z, p[6].z, p[5].z, p[4].z, p[3].z, p[2].z, p[1].z, p[0].z);
+
+        // Each half holds the entries of four nodes
+        __m128 low[12], high[12];
+        for (int k = 0; k < 12; k++){
+            low[k] = _mm256_castps256_ps128(r[k]);
+            high[k] = _mm256_extractf128_ps(r[k], 1);
+        }
+        StoreLocalSSE(i, low, world_transf);
+        StoreLocalSSE(i + 4, high, world_transf);
+
+        for (int k = i; k < i + 8; k++){
+            FinishNodeAVX2(k, parent, scale, world_transf, world_mat, normal_mat);
+        }
+    }
+
+    // Remaining nodes one at a time
+    for (; i < end; i++){
+        LocalScalar(i, position, orientation, world_transf);
+        FinishNodeAVX2(i, parent, scale, world_transf, world_mat, normal_mat);
+    }
+}
+
+#endif // TRANSFORM_KERNEL_X86
+
+
+void TransformKernel::Compose(int first, int count, const int *parent,
+                              const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                              glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    if (!selected_){
+        Select();
+    }
+
+    if (path_ == AVX2){
+        ComposeAVX2(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+    } else if (path_ == SSE){
+        ComposeSSE(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+    } else {
+        ComposeScalar(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+    }
+}
+
+
+TransformKernel::Path TransformKernel::GetPath(void){
+
+    if (!selected_){
+        Select();
+    }
+    return path_;
+}
+
+
+void TransformKernel::SetPath(Path path){
+
+    path_ = IsSupported(path) ? path : Scalar;
+    selected_ = true;
+}
+
+
+bool TransformKernel::IsSupported(Path path){
+
+    if (path == Scalar){
+        return true;
+    }
+#if defined(TRANSFORM_KERNEL_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    if (path == SSE){
+        return (info[3] & (1 << 26)) != 0;
+    }
+    // AVX2 also needs the operating system to save the AVX registers
+    bool avx = ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    return avx && ((info[1] & (1 << 5)) != 0);
+#elif defined(TRANSFORM_KERNEL_X86)
+    __builtin_cpu_init();
+    if (path == SSE){
+        return __builtin_cpu_supports("sse2");
+    }
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+
+const char *TransformKernel::GetPathName(Path path){
+
+    if (path == AVX2){
+        return "avx2";
+    } else if (path == SSE){
+        return "sse";
+    }
+    return "scalar";
+}
+
+
+float TransformKernel::Test(Path path){
+
+    if (!IsSupported(path)){
+        return INFINITY;
+    }
+
+    // Random nodes from a fixed linear congruential sequence, so that the
+    // test does not disturb the sequence of rand()
+    unsigned int seed = 12345;
+    std::vector<int> parent(kernel_test_nodes_g);
+    std::vector<glm::vec3> position(kernel_test_nodes_g), scale(kernel_test_nodes_g);
+    std::vector<glm::quat> orientation(kernel_test_nodes_g);
+    for (int i = 0; i < kernel_test_nodes_g; i++){
+        float v[11];
+        for (int k = 0; k < 11; k++){
+            seed = seed*1664525 + 1013904223;
+            v[k] = (seed >> 8) / 16777216.0f;
+        }
+        parent[i] = (int) (v[0]*(i + 1)) - 1;
+        position[i] = glm::vec3(v[1], v[2], v[3])*20.0f - 10.0f;
+        orientation[i] = glm::normalize(glm::quat(v[4] - 0.5f, v[5] - 0.5f, v[6] - 0.5f, v[7] - 0.5f));
+        scale[i] = glm::vec3(v[8], v[9], v[10])*2.0f + 0.1f;
+    }
+
+    std::vector<glm::mat4> ref_transf(kernel_test_nodes_g), ref_mat(kernel_test_nodes_g), ref_normal(kernel_test_nodes_g);
+    std::vector<glm::mat4> transf(kernel_test_nodes_g), mat(kernel_test_nodes_g), normal(kernel_test_nodes_g);
+    ComposeScalar(0, kernel_test_nodes_g, &parent[0], &position[0], &orientation[0], &scale[0], &ref_transf[0], &ref_mat[0], &ref_normal[0]);
+    if (path == AVX2){
+        ComposeAVX2(0, kernel_test_nodes_g, &parent[0], &position[0], &orientation[0], &scale[0], &transf[0], &mat[0], &normal[0]);
+    } else if (path == SSE){
+        ComposeSSE(0, kernel_test_nodes_g, &parent[0], &position[0], &orientation[0], &scale[0], &transf[0], &mat[0], &normal[0]);
+    } else {
+        ComposeScalar(0, kernel_test_nodes_g, &parent[0], &position[0], &orientation[0], &scale[0], &transf[0], &mat[0], &normal[0]);
+    }
+
+    // Largest difference relative to the magnitude of the entries
+    float error = 0.0;
+    for (int i = 0; i < kernel_test_nodes_g; i++){
+        for (int c = 0; c < 4; c++){
+            for (int r = 0; r < 4; r++){
+                error = glm::max(error, fabs(transf[i][c][r] - ref_transf[i][c][r]) / glm::max(1.0f, fabs(ref_transf[i][c][r])));
+                error = glm::max(error, fabs(mat[i][c][r] - ref_mat[i][c][r]) / glm::max(1.0f, fabs(ref_mat[i][c][r])));
+                error = glm::max(error, fabs(normal[i][c][r] - ref_normal[i][c][r]) / glm::max(1.0f, fabs(ref_normal[i][c][r])));
+            }
+        }
+    }
+    return error;
+}
+
+
+void TransformKernel::Select(void){
+
+    // Fastest implementation that the processor has and that agrees with
+    // the reference
+    path_ = Scalar;
+    const Path simd[] = { AVX2, SSE };
+    for (int i = 0; i < 2; i++){
+        if (!IsSupported(simd[i])){
+            continue;
+        }
+        float error = Test(simd[i]);
+        if (error <= kernel_tolerance_g){
+            path_ = simd[i];
+            break;
+        }
+        std::cerr << "Transform kernel " << GetPathName(simd[i]) << " differs from the reference by " << error << "; not used" << std::endl;
+    }
+    selected_ = true;
+}
+
+
+void TransformKernel::ComposeScalar(int first, int count, const int *parent,
+                                    const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                    glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+    for (int i = first; i < first + count; i++){
+        glm::mat4 parent_transf = (parent[i] >= 0) ? world_transf[parent[i]] : glm::mat4(1.0);
+        TransformHierarchy::ComputeTransforms(parent_transf, position[i], orientation[i], scale[i], world_transf[i], world_mat[i], normal_mat[i]);
+    }
+}
+
+
+void TransformKernel::ComposeSSE(int first, int count, const int *parent,
+                                 const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                 glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+#ifdef TRANSFORM_KERNEL_X86
+    ComposeBlocksSSE(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+#else
+    ComposeScalar(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+#endif
+}
+
+
+void TransformKernel::ComposeAVX2(int first, int count, const int *parent,
+                                  const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                  glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat){
+
+#ifdef TRANSFORM_KERNEL_X86
+    ComposeBlocksAVX2(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+#else
+    ComposeScalar(first, count, parent, position, orientation, scale, world_transf, world_mat, normal_mat);
+#endif
+}
+
+} // namespace game
@@ -0,0 +1,61 @@
+#ifndef TRANSFORM_KERNEL_H_
+#define TRANSFORM_KERNEL_H_
+
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+namespace game {
+
+    // Batch computation of world and normal matrices from the local
+    // state of nodes, with SSE and AVX2 versions chosen at run time
+    // All versions give the same results as the glm reference in
+    // TransformHierarchy::ComputeTransforms
+    class TransformKernel {
+
+        public:
+            // Implementations of the kernel
+            enum Path { Scalar, SSE, AVX2 };
+
+            // Compute the matrices of nodes first to first + count - 1
+            // Parent indices refer to the same arrays, and each parent
+            // comes before its children, so its world transformation is
+            // either outside of the range or computed earlier in the call
+            static void Compose(int first, int count, const int *parent,
+                                const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat);
+
+            // Implementation used by Compose(); by default, the fastest one
+            // supported by the processor that passes the self-test
+            static Path GetPath(void);
+            // Force an implementation; unsupported ones fall back to Scalar
+            static void SetPath(Path path);
+            static bool IsSupported(Path path);
+            static const char *GetPathName(Path path);
+
+            // Largest difference between an implementation and the
+            // reference on a set of random nodes
+            static float Test(Path path);
+
+        private:
+            static Path path_;
+            static bool selected_;
+
+            // Pick the implementation on first use
+            static void Select(void);
+
+            static void ComposeScalar(int first, int count, const int *parent,
+                                      const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                      glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat);
+            static void ComposeSSE(int first, int count, const int *parent,
+                                   const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                   glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat);
+            static void ComposeAVX2(int first, int count, const int *parent,
+                                    const glm::vec3 *position, const glm::quat *orientation, const glm::vec3 *scale,
+                                    glm::mat4 *world_transf, glm::mat4 *world_mat, glm::mat4 *normal_mat);
+
+    }; // class TransformKernel
+
+} // namespace game
+
+#endif // TRANSFORM_KERNEL_H_
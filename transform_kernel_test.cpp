@@ -0,0 +1,194 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "transform_kernel.h"
+
+// Test settings
+const float tolerance_g = 1e-4; // Largest relative difference accepted
+const unsigned int seed_g = 1; // Seed of the random nodes
+const int random_nodes_g = 1003; // Not a multiple of the batch sizes
+const int chain_depth_g = 2001;
+
+
+// Nodes of a hierarchy, in the layout the kernel takes
+struct Hierarchy {
+    std::string name;
+    std::vector<int> parent;
+    std::vector<glm::vec3> position;
+    std::vector<glm::quat> orientation;
+    std::vector<glm::vec3> scale;
+};
+
+
+// Add a node; parents must be added before their children
+void AddNode(Hierarchy &h, int parent, glm::vec3 position, glm::quat orientation, glm::vec3 scale){
+
+    h.parent.push_back(parent);
+    h.position.push_back(position);
+    h.orientation.push_back(orientation);
+    h.scale.push_back(scale);
+}
+
+
+// Random unit quaternion
+glm::quat RandomOrientation(std::mt19937 &random){
+
+    std::uniform_real_distribution<float> component(-1.0, 1.0);
+    glm::quat q;
+    do {
+        q = glm::quat(component(random), component(random), component(random), component(random));
+    } while (glm::length(q) < 0.1);
+    return glm::normalize(q);
+}
+
+
+// Tree with random parents, positions, orientations and scales
+Hierarchy RandomTree(void){
+
+    std::mt19937 random(seed_g);
+    std::uniform_real_distribution<float> coordinate(-10.0, 10.0);
+    std::uniform_real_distribution<float> factor(0.1, 2.0);
+    Hierarchy h;
+    h.name = "random tree";
+    for (int i = 0; i < random_nodes_g; i++){
+        int parent = (int) (random() % (i + 1)) - 1;
+        glm::vec3 position(coordinate(random), coordinate(random), coordinate(random));
+        glm::vec3 scale(factor(random), factor(random), factor(random));
+        AddNode(h, parent, position, RandomOrientation(random), scale);
+    }
+    return h;
+}
+
+
+// Scales with zero components, which are not inherited by the children
+Hierarchy ZeroScale(void){
+
+    std::mt19937 random(seed_g);
+    Hierarchy h;
+    h.name = "zero scale";
+    const glm::vec3 scale[] = { glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 1.0),
+                                glm::vec3(1.0, 0.0, 1.0), glm::vec3(1.0, 1.0, 0.0) };
+    for (int i = 0; i < 37; i++){
+        AddNode(h, i - 1, glm::vec3(1.0, -0.5, 0.25), RandomOrientation(random), scale[i % 4]);
+    }
+    return h;
+}
+
+
+// Strongly non-uniform scales, and nodes with no rotation or offset
+Hierarchy NonUniformScale(void){
+
+    std::mt19937 random(seed_g);
+    Hierarchy h;
+    h.name = "non-uniform scale";
+    for (int i = 0; i < 29; i++){
+        glm::quat orientation = (i % 3 == 0) ? glm::quat(1.0, 0.0, 0.0, 0.0) : RandomOrientation(random);
+        glm::vec3 position = (i % 5 == 0) ? glm::vec3(0.0) : glm::vec3(0.5, 2.0, -1.0);
+        AddNode(h, (i / 2) - 1, position, orientation, glm::vec3(100.0, 0.01, 1.0 + i));
+    }
+    return h;
+}
+
+
+// Single chain of small steps, so that errors build up along it
+Hierarchy DeepChain(void){
+
+    std::mt19937 random(seed_g);
+    std::uniform_real_distribution<float> step(-0.05, 0.05);
+    Hierarchy h;
+    h.name = "deep chain";
+    for (int i = 0; i < chain_depth_g; i++){
+        glm::quat turn = glm::angleAxis(step(random), glm::normalize(glm::vec3(1.0, 2.0, 3.0)));
+        AddNode(h, i - 1, glm::vec3(step(random), step(random), 0.1), turn, glm::vec3(1.5, 0.5, 1.0));
+    }
+    return h;
+}
+
+
+// Difference between two matrices, relative to the largest entry of the
+// reference, since the inverse in the reference loses precision in
+// proportion to the translation
+float Difference(const glm::mat4 &a, const glm::mat4 &ref){
+
+    float error = 0.0;
+    float magnitude = 1.0;
+    for (int c = 0; c < 4; c++){
+        for (int r = 0; r < 4; r++){
+            error = glm::max(error, fabs(a[c][r] - ref[c][r]));
+            magnitude = glm::max(magnitude, fabs(ref[c][r]));
+        }
+    }
+    return error / magnitude;
+}
+
+
+// Compare one implementation of the kernel with the matrices that
+// SceneNode::SetupShader used to compute: parent * translation * rotation,
+// then the scale for the world matrix, and the inverse transpose of the
+// unscaled transformation for the normal matrix
+// Return whether all nodes are within the tolerance
+bool Check(game::TransformKernel::Path path, const Hierarchy &h){
+
+    int count = h.parent.size();
+    std::vector<glm::mat4> transf(count), mat(count), normal(count);
+    game::TransformKernel::SetPath(path);
+    game::TransformKernel::Compose(0, count, &h.parent[0], &h.position[0], &h.orientation[0], &h.scale[0],
+                                   &transf[0], &mat[0], &normal[0]);
+
+    float error = 0.0;
+    int worst = 0;
+    std::vector<glm::mat4> ref_transf(count);
+    for (int i = 0; i < count; i++){
+        glm::mat4 parent_transf = (h.parent[i] >= 0) ? ref_transf[h.parent[i]] : glm::mat4(1.0);
+        glm::mat4 translation = glm::translate(glm::mat4(1.0), h.position[i]);
+        glm::mat4 rotation = glm::mat4_cast(h.orientation[i]);
+        ref_transf[i] = parent_transf * translation * rotation;
+        glm::mat4 ref_mat = ref_transf[i] * glm::scale(glm::mat4(1.0), h.scale[i]);
+        glm::mat4 ref_normal = glm::transpose(glm::inverse(ref_transf[i]));
+
+        float node_error = glm::max(Difference(transf[i], ref_transf[i]),
+                                    glm::max(Difference(mat[i], ref_mat), Difference(normal[i], ref_normal)));
+        if (node_error > error){
+            error = node_error;
+            worst = i;
+        }
+    }
+
+    bool pass = (error <= tolerance_g);
+    std::cout << (pass ? "ok   " : "FAIL ") << game::TransformKernel::GetPathName(path) << ", " << h.name
+              << ": largest difference " << error << " at node " << worst << std::endl;
+    return pass;
+}
+
+
+// Test of all implementations of the transform kernel against the glm
+// reference, on random and edge-case hierarchies
+// Implementations the processor lacks are skipped
+int main(void){
+
+    std::vector<Hierarchy> hierarchy;
+    hierarchy.push_back(RandomTree());
+    hierarchy.push_back(ZeroScale());
+    hierarchy.push_back(NonUniformScale());
+    hierarchy.push_back(DeepChain());
+
+    const game::TransformKernel::Path path[] = { game::TransformKernel::Scalar, game::TransformKernel::SSE, game::TransformKernel::AVX2 };
+    bool pass = true;
+    for (int p = 0; p < 3; p++){
+        if (!game::TransformKernel::IsSupported(path[p])){
+            std::cout << "skip " << game::TransformKernel::GetPathName(path[p]) << ": not supported" << std::endl;
+            continue;
+        }
+        for (int i = 0; i < hierarchy.size(); i++){
+            pass = Check(path[p], hierarchy[i]) && pass;
+        }
+    }
+
+    return pass ? 0 : 1;
+}